@@ -6,7 +6,15 @@
         "src/binding.cc",
         "src/sif_parser.c",
         "src/sif_json.c",
-        "src/sif_utils.c"
+        "src/sif_utils.c",
+        "src/sif_prefetch.c",
+        "src/sif_iter.c",
+        "src/sif_cache.c",
+        "src/sif_stats.c",
+        "src/sif_convert.c",
+        "src/sif_alloc.c",
+        "src/sif_compress.c",
+        "src/sif_roi.c"
       ],
       "include_dirs": [
         "include",
@@ -15,9 +23,16 @@
       "cflags_cc": ["-std=c++17", "-fexceptions"],
       "cflags_c": ["-std=c99", "-DDEBUG"],
       "defines": [
-        "NODE_ADDON_API_CPP_EXCEPTIONS"
+        "NODE_ADDON_API_CPP_EXCEPTIONS",
+        "SIF_MIN_LOG_LEVEL=2",
+        "SIF_HAVE_ZLIB"
       ],
-      "libraries": ["-lm"]
+      "libraries": ["-lm", "-lpthread", "-lz"],
+      "conditions": [
+        ["OS=='linux'", {
+          "defines": ["SIF_HAVE_IO_URING"]
+        }]
+      ]
     }
   ]
 }
\ No newline at end of file
@@ -0,0 +1,72 @@
+/*
+ * csif - Andor SIF Parser in C
+ * Copyright (C) 2025 mithgil
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SIF_ALLOC_H
+#define SIF_ALLOC_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// All three functions are required. They may be called from the library's
+// loader and cache threads, so they must be thread-safe.
+typedef struct {
+    void *(*malloc_fn)(size_t size, void *user_data);
+    void *(*realloc_fn)(void *ptr, size_t size, void *user_data);
+    void (*free_fn)(void *ptr, void *user_data);
+    void *user_data;
+} SifAllocator;
+
+// Process-wide allocator, used by handles opened without their own
+// (SifOpenOptions.allocator / use_arena) and for buffers handed to the
+// caller (sif_file_to_json, retrieve_calibration, extract_calibration).
+// NULL restores malloc/realloc/free. Only change it while no handle is open
+// and no returned buffer is outstanding; returns -1 for an incomplete table.
+int sif_set_allocator(const SifAllocator *allocator);
+
+// release a buffer returned by the library (free() is fine as long as no
+// allocator has been set)
+void sif_free(void *ptr);
+
+// library hooks: per-handle allocation state, NULL uses the process-wide
+// allocator. With an arena, small blocks are bump-allocated from chunks and
+// only released all at once by sif_alloc_destroy; large blocks (frame data)
+// still go back to the backing allocator when freed.
+struct SifAllocState;
+
+struct SifAllocState *sif_alloc_create(const SifAllocator *allocator, int use_arena);
+void sif_alloc_destroy(struct SifAllocState *state);
+void *sif_mem_alloc(struct SifAllocState *state, size_t size);
+void *sif_mem_calloc(struct SifAllocState *state, size_t count, size_t size);
+void *sif_mem_realloc(struct SifAllocState *state, void *ptr, size_t size);
+void sif_mem_free(struct SifAllocState *state, void *ptr);
+char *sif_mem_strdup(struct SifAllocState *state, const char *str);
+
+// arena only: forget every small block but keep the chunks for the next
+// file on the handle (sif_reset); large blocks stay valid
+void sif_alloc_rewind(struct SifAllocState *state);
+// 0 for a small arena block, which sif_alloc_rewind invalidates
+int sif_mem_survives_rewind(struct SifAllocState *state, const void *ptr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
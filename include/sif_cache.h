@@ -0,0 +1,58 @@
+/*
+ * csif - Andor SIF Parser in C
+ * Copyright (C) 2025 mithgil
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SIF_CACHE_H
+#define SIF_CACHE_H
+
+#include <stdint.h>
+#include "sif_parser.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    size_t bytes_used;
+    size_t budget_bytes;
+    int frames_cached;
+} SifCacheStats;
+
+// Keep decoded frames of an open file in memory up to budget_bytes, with
+// CLOCK eviction. Lookups may come from several threads at once.
+int sif_cache_enable(SifFile *sif_file, size_t budget_bytes, int enable_byte_swap);
+void sif_cache_disable(SifFile *sif_file);
+
+// Pin a frame (info.pixels_per_frame pixels, all tracks) in the cache,
+// reading it on a miss. The pointer stays valid
+// until the matching sif_cache_release; NULL if every slot is pinned.
+const float *sif_cache_acquire(SifFile *sif_file, int frame_index);
+void sif_cache_release(SifFile *sif_file, int frame_index);
+
+// acquire + copy + release
+int sif_cache_copy_frame(SifFile *sif_file, int frame_index, float *output_buffer);
+
+void sif_cache_get_stats(SifFile *sif_file, SifCacheStats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
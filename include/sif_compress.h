@@ -0,0 +1,55 @@
+/*
+ * csif - Andor SIF Parser in C
+ * Copyright (C) 2025 mithgil
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SIF_COMPRESS_H
+#define SIF_COMPRESS_H
+
+#include "sif_parser.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    SIF_COMPRESSION_NONE = 0,
+    SIF_COMPRESSION_GZIP,          // .sif.gz, needs a zlib build
+    SIF_COMPRESSION_ZSTD,          // .sif.zst, needs a libzstd build
+    SIF_COMPRESSION_ZSTD_SEEKABLE  // zstd seekable format: random access through its seek table
+} SifCompression;
+
+// sif_open and friends recognise compressed files by their first bytes and
+// decode them on the fly. gzip and plain zstd are streams: reads that go
+// backwards start decoding over from the beginning, so frames are best read
+// in file order (sif_load_all_frames, sif_frame_iter). Seekable zstd archives
+// only decode the compressed frames a read touches.
+SifCompression sif_get_compression(const SifFile *sif_file);
+SifCompression sif_detect_compression(const unsigned char *head, size_t length);
+const char *sif_compression_name(SifCompression compression);
+int sif_compression_supported(SifCompression compression);  // built with zlib / libzstd
+
+// library hooks: positional reads of the decompressed file
+struct SifDecoder *sif_decoder_open(FILE *fp, SifCompression compression, struct SifAllocState *alloc);
+void sif_decoder_close(struct SifDecoder *decoder);
+SifCompression sif_decoder_compression(const struct SifDecoder *decoder);
+int64_t sif_decoder_pread(struct SifDecoder *decoder, void *dst, size_t count, int64_t offset);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
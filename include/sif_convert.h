@@ -0,0 +1,65 @@
+/*
+ * csif - Andor SIF Parser in C
+ * Copyright (C) 2025 mithgil
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SIF_CONVERT_H
+#define SIF_CONVERT_H
+
+#include <stddef.h>
+#include "sif_parser.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    SIF_DTYPE_FLOAT32 = 0,
+    SIF_DTYPE_FLOAT64,
+    SIF_DTYPE_FLOAT16,            // IEEE half, round to nearest even
+    SIF_DTYPE_BFLOAT16,           // top half of a float32, round to nearest even
+    SIF_DTYPE_UINT16,             // value * scale + offset, rounded and clamped
+    SIF_DTYPE_UINT32
+} SifDtype;
+
+typedef struct {
+    SifDtype dtype;
+    double scale;                 // integer outputs only
+    double offset;
+    int enable_byte_swap;
+} SifConvertOptions;
+
+extern const SifConvertOptions SIF_DEFAULT_CONVERT_OPTIONS;  // float64, scale 1, offset 0
+
+// Read whole frames (all tracks) straight into out as options.dtype. Pixels
+// are read in cache-sized chunks and converted in the same pass, so no
+// float32 copy of the frames is ever made. out holds frame_count *
+// info.pixels_per_frame * sif_dtype_size(dtype) bytes. Like sif_read_frames
+// it does not touch the handle and may be called from many threads.
+int sif_read_frames_as(const SifFile *sif_file, int start_frame, int frame_count,
+                       void *out, SifConvertOptions options);
+
+// Convert count float32 values already in memory, with the same kernels
+int sif_convert_pixels(const float *src, void *dst, size_t count, SifConvertOptions options);
+
+size_t sif_dtype_size(SifDtype dtype);
+const char *sif_dtype_name(SifDtype dtype);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
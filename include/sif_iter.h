@@ -0,0 +1,47 @@
+/*
+ * csif - Andor SIF Parser in C
+ * Copyright (C) 2025 mithgil
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SIF_ITER_H
+#define SIF_ITER_H
+
+#include "sif_parser.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct SifFrameIter SifFrameIter;
+
+// Constant-memory pass over all frames of an open file. Frames come in
+// batches of up to batch_frames; while the caller works on one batch the
+// next one is read by a background thread into the second buffer.
+SifFrameIter *sif_frame_iter_open(SifFile *sif_file, int batch_frames, int enable_byte_swap);
+
+// Number of frames in the next batch (0 at the end, -1 on error). *frames
+// points at count * info.pixels_per_frame pixels (every track of each
+// frame) and stays valid until the next
+// call; *first_frame receives the index of its first frame.
+int sif_frame_iter_next(SifFrameIter *iter, const float **frames, int *first_frame);
+
+void sif_frame_iter_close(SifFrameIter *iter);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -41,7 +41,7 @@ extern const JsonOutputOptions JSON_DEFAULT_OPTIONS;
 extern const JsonOutputOptions JSON_METADATA_ONLY_OPTIONS;
 extern const JsonOutputOptions JSON_FULL_DATA_OPTIONS;
 
-// main json output functions
+// main json output functions; the returned strings are released with sif_free
 char* sif_file_to_json(SifFile *sif_file, JsonOutputOptions options);
 char* sif_info_to_json(SifInfo *info);
 char* sif_frame_data_to_json(SifFile *sif_file, int frame_index, JsonOutputOptions options);
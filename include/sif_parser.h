@@ -29,12 +29,13 @@ extern "C" {
 #include <string.h>
 #include <math.h>
 #include <stdarg.h>
+#include <pthread.h>
+#include "sif_alloc.h"
 
 #define SIF_MAGIC "Andor Technology Multi-Channel File\n"
 #define MAX_STRING_LENGTH 1024
 #define MAX_USER_TEXT_LENGTH 8192
 #define MAX_CALIBRATION_COEFFS 10
-#define MAX_FRAMES 100
 #define MAX_COEFFICIENTS 20
 
 
@@ -48,10 +49,27 @@ typedef enum {
 
 extern SifVerboseLevel current_verbose_level;
 
+// receives one formatted message; level is the message's level
+typedef void (*SifLogCallback)(SifVerboseLevel level, const char *message, void *user_data);
+
+typedef struct {
+    SifVerboseLevel level;        // most detailed level passed on
+    SifLogCallback callback;      // NULL: write to stdout
+    void *user_data;
+} SifLogSink;
+
+// Least important level compiled into the library. Building with e.g.
+// -DSIF_MIN_LOG_LEVEL=2 turns PRINT_VERBOSE/PRINT_DEBUG into no-ops whose
+// arguments are never evaluated.
+#ifndef SIF_MIN_LOG_LEVEL
+#define SIF_MIN_LOG_LEVEL 4
+#endif
+
 typedef struct {
     int x0, y0, x1, y1;
     int xbin, ybin;
     int width, height;
+    int offset;                   // first pixel of this track within a frame
 } SubImageInfo;
 
 typedef struct {
@@ -61,17 +79,31 @@ typedef struct {
 
 typedef struct {
 
-    SifVerboseLevel verbose_level;
+    // per-handle logging (SifOpenOptions.log, sif_set_log_sink)
+    SifLogSink log;
+    int has_log;                  // 0: global level, stdout
 
-    char detector_type[MAX_STRING_LENGTH];
-    char original_filename[MAX_STRING_LENGTH];
-    char spectrograph[MAX_STRING_LENGTH];
-    char user_text[MAX_USER_TEXT_LENGTH];
+    // where the handle's tables and frames come from (SifOpenOptions.allocator,
+    // use_arena), NULL: the process-wide allocator
+    struct SifAllocState *alloc;
+
+    // the handle's counters (SifFile.stats), for work done later through
+    // SifInfo accessors such as sif_ensure_calibration
+    struct SifStatsState *stats;
+
+    // interned strings, shared between handles; "" when absent, never NULL
+    const char *detector_type;
+    const char *original_filename;
+    const char *spectrograph;
+    char *user_text;              // kept with SifOpenOptions.keep_user_text, else only read while calibration is parsed
     int user_text_length; 
     int user_text_processed;  
-    char frame_axis[MAX_STRING_LENGTH];
-    char data_type[MAX_STRING_LENGTH];
-    char image_axis[MAX_STRING_LENGTH];
+    int user_text_kept;           // SifOpenOptions.keep_user_text
+    int calibration_parsed;       // calibration fields below are filled (sif_ensure_calibration)
+    pthread_mutex_t calibration_lock; // held while they are parsed, one per handle
+    const char *frame_axis;
+    const char *data_type;
+    const char *image_axis;
     
     int sif_version;
     int sif_calb_version;
@@ -79,8 +111,8 @@ typedef struct {
     int accumulated_cycles;
     int number_of_frames;
     int number_of_subimages;
-    int total_length;
-    int image_length;
+    int64_t total_length;
+    int64_t image_length;
     int detector_width;
     int detector_height;
     int xbin, ybin;
@@ -99,12 +131,14 @@ typedef struct {
     double gate_delay;
     double raman_ex_wavelength;
 
-    char calibration_data[256];  
+    // parsed on first use: call sif_ensure_calibration (or a calibration
+    // accessor) before reading the coefficients or frame calibrations
+    char *calibration_data;       // raw calibration line, NULL if absent
     double calibration_coefficients[10];
     int calibration_coeff_count;  
 
     int has_frame_calibrations;    
-    FrameCalibration frame_calibrations[MAX_FRAMES];
+    FrameCalibration *frame_calibrations;  // number_of_frames entries, NULL without per-frame calibration
     
     SubImageInfo *subimages;
     int64_t *timestamps;
@@ -112,38 +146,119 @@ typedef struct {
     int64_t data_offset;
     int image_width;
     int image_height;
+    size_t pixels_per_frame;      // every track (subimage) of a frame, the frame stride in the file
     
 } SifInfo;
 
+// a buffer kept across sif_reset, reused when the next file needs exactly
+// the same size
 typedef struct {
-    int64_t offset;
-    int width;
-    int height;
-    int frame_index;
-} ImageTile;
+    void *data;
+    size_t bytes;
+} SifSpareBuffer;
 
 typedef struct {
-    ImageTile *tiles;
     int frame_count;
-    int tile_count;
     SifInfo info;
     
     // data storage
-    float *frame_data;            // 1D：frame_data[frame * height * width + row * width + col]
+    float *frame_data;            // 1D：frame_data[frame * pixels_per_frame + subimage offset + row * width + col]
     int data_loaded;              // mark for data to be loaded
+    int first_loaded_frame;       // frame held at the start of frame_data
+    int loaded_frame_count;       // number of frames held in frame_data
     
     FILE *file_ptr;               // File pointer (used for lazy loading)
     const char *filename;         // File name (used to reopen the file)
+
+    // memory mapping (sif_open_mmap)
+    void *map_base;               // read-only mapping (or in-memory image) of the whole file, NULL if not mapped
+    size_t map_length;            // mapping size in bytes
+    int map_borrowed;             // map_base is a sif_open_memory buffer, not unmapped
+    int data_mapped;              // frame_data points into the mapping (not owned)
+
+    // decompressor for a gzip/zstd file (sif_compress.h), NULL for a plain file
+    struct SifDecoder *decoder;
+
+    // read-ahead for frames outside the loaded window (sif_prefetch_enable)
+    struct SifPrefetcher *prefetcher;
+
+    // decoded frames kept up to a memory budget (sif_cache_enable)
+    struct SifFrameCache *cache;
+
+    // performance counters and trace (SIF_ENABLE_STATS builds, else NULL)
+    struct SifStatsState *stats;
+
+    // user text not read at open (no SifOpenOptions.keep_user_text)
+    int64_t user_text_offset;
+
+    // undecoded timestamp block (SifOpenOptions.lazy_timestamps)
+    int64_t timestamp_offset;
+    size_t timestamp_length;
+    int lazy_timestamps;          // SifOpenOptions.lazy_timestamps, kept by sif_reopen
+
+    // the previous file's buffers, kept by sif_reset for a file of the same shape
+    SifSpareBuffer spare_frames;
+    SifSpareBuffer spare_timestamps;
+    SifSpareBuffer spare_subimages;
     
 } SifFile;
 
-// main functions
+typedef struct {
+    int keep_user_text;           // keep info.user_text after parsing
+    const SifLogSink *log;        // handle's log sink (copied), NULL: global level
+    size_t trace_events;          // trace capacity from open on (SIF_ENABLE_STATS builds)
+    int lazy_timestamps;          // leave info.timestamps NULL until sif_get_timestamps
+    const SifAllocator *allocator; // handle's allocator (copied), NULL: process-wide allocator
+    int use_arena;                // bump-allocate the handle's small tables, released by sif_close
+} SifOpenOptions;
+
+// default options
+extern const SifOpenOptions SIF_DEFAULT_OPEN_OPTIONS;
+
+// header summary returned by sif_probe
+typedef struct {
+    int sif_version;
+    int number_of_frames;
+    int number_of_subimages;
+    int image_width;              // first track
+    int image_height;
+    size_t pixels_per_frame;      // all tracks
+    double exposure_time;
+    double detector_temperature;
+    int64_t data_offset;
+    char detector_type[MAX_STRING_LENGTH];
+} SifProbe;
+
+// main functions. An open that fails has already released whatever it set
+// up and leaves the handle zeroed (sif_close on it does nothing); the
+// caller only closes fp.
 int sif_open(FILE *fp, SifFile *sif_file);
+int sif_open_ex(FILE *fp, SifFile *sif_file, SifOpenOptions options);
+int sif_open_mmap(FILE *fp, SifFile *sif_file);
+int sif_open_memory(const void *buffer, size_t length, SifFile *sif_file);
+int sif_open_memory_ex(const void *buffer, size_t length, SifFile *sif_file, SifOpenOptions options);
+int sif_probe(const char *path, SifProbe *probe);
 void sif_close(SifFile *sif_file);
+// Reuse a handle for the next file: sif_reset drops the current file but
+// keeps the handle's options (log sink, allocator, arena chunks, counters)
+// and its frame, timestamp and subimage buffers; sif_reopen parses fp into
+// the handle, taking those buffers over when the shape matches. The handle
+// still needs sif_close at the end.
+void sif_reset(SifFile *sif_file);
+int sif_reopen(SifFile *sif_file, FILE *fp);
+int64_t sif_frame_offset(const SifFile *sif_file, int frame_index);
+// info.timestamps, decoded from the file on first call after a lazy open
+const int64_t *sif_get_timestamps(SifFile *sif_file);
 int extract_calibration(const SifInfo *info, double **calibration, int *calib_width, int *calib_frames);
+// parse the calibration once, thread-safe. info is an open handle's
+// (&sif_file->info); without keep_user_text the user text is read back from
+// the file, which like a lazy open's timestamps must still be open
+void sif_ensure_calibration(const SifInfo *info);
 
 // Data reading function
 int sif_load_all_frames(SifFile *sif_file, int enable_byte_swap);
+int sif_load_all_frames_parallel(SifFile *sif_file, int enable_byte_swap, int num_threads);
+int sif_load_all_frames_direct(SifFile *sif_file, int enable_byte_swap);
 int sif_load_single_frame(SifFile *sif_file, int frame_index);
 int sif_load_frame_range(SifFile *sif_file, int start_frame, int end_frame);
 void sif_unload_data(SifFile *sif_file);
@@ -152,7 +267,29 @@ void sif_unload_data(SifFile *sif_file);
 float *sif_get_frame_data(SifFile *sif_file, int frame_index);
 int sif_save_frame_as_text(SifFile *sif_file, int frame_index, const char *filename);
 float sif_get_pixel_value(SifFile *sif_file, int frame_index, int row, int col);
+// -1 for a frame neither loaded nor cached, sif_read_frames reads it
 int sif_copy_frame_data(SifFile *sif_file, int frame_index, float *output_buffer);
+int sif_read_frames(const SifFile *sif_file, int start_frame, int frame_count,
+                    float *output_buffer, int enable_byte_swap);
+// Sampled reads for previews: only the chosen frames are read, packed into
+// output_buffer in order (frame_count frames). Thread-safe like sif_read_frames.
+int sif_read_frames_strided(const SifFile *sif_file, int start_frame, int stride, int frame_count,
+                            float *output_buffer, int enable_byte_swap);  // every stride-th frame
+int sif_read_frame_list(const SifFile *sif_file, const int *frame_indices, int count,
+                        float *output_buffer, int enable_byte_swap);
+// up to target_frames evenly spaced frame indices, first and last included;
+// returns how many were written
+int sif_decimate_frames(const SifFile *sif_file, int target_frames, int *frame_indices);
+// those frames in a new buffer (release with sif_free), count in *frame_count
+float *sif_load_decimated(const SifFile *sif_file, int target_frames, int enable_byte_swap, int *frame_count);
+// pixel-granular positional read at a file offset (byte swap fused in), used
+// by sif_convert.c; returns pixels read or -1
+int64_t sif_read_pixels(const SifFile *sif_file, int64_t offset, float *output_buffer,
+                        size_t pixel_count, int enable_byte_swap);
+// positional read of the (decompressed) file, what pread is to a plain file;
+// returns bytes read, short only at the end of the file, or -1
+int64_t sif_read_at(const SifFile *sif_file, void *buffer, size_t count, int64_t offset);
+float *sif_get_track_data(SifFile *sif_file, int frame_index, int track, int *width, int *height);
 
 // helper functions
 int read_until(FILE *fp, char *buffer, int max_length, char terminator);
@@ -168,11 +305,26 @@ void parse_frame_calibration_coefficients(SifInfo *info, int frame, const char*
 void sif_set_verbose_level(SifVerboseLevel level);
 void sif_print(SifVerboseLevel min_level, const char* format, ...);
 
+// per-handle log sink, NULL reverts the handle to the global level
+void sif_set_log_sink(SifFile *sif_file, const SifLogSink *log);
+
+// Library entry points route PRINT_* output of the calling thread to the
+// handle's sink between these two calls (nesting is allowed).
+const SifLogSink *sif_log_enter(const SifInfo *info);
+void sif_log_leave(const SifLogSink *previous);
+SifVerboseLevel sif_log_level(void);
+
+// guard for logging work beyond the message itself (dumps, extra reads)
+#define SIF_LOG_ENABLED(level) ((level) <= SIF_MIN_LOG_LEVEL && sif_log_level() >= (level))
+
 // Convenience macro (defined in header file)
-#define PRINT_SILENT(...)   sif_print(SIF_SILENT, __VA_ARGS__)
-#define PRINT_NORMAL(...)   sif_print(SIF_NORMAL, __VA_ARGS__)
-#define PRINT_VERBOSE(...)  sif_print(SIF_VERBOSE, __VA_ARGS__)
-#define PRINT_DEBUG(...)    sif_print(SIF_DEBUG, __VA_ARGS__)
+#define SIF_PRINT_AT(level, ...) \
+    do { if ((level) <= SIF_MIN_LOG_LEVEL) sif_print((level), __VA_ARGS__); } while (0)
+
+#define PRINT_SILENT(...)   SIF_PRINT_AT(SIF_SILENT, __VA_ARGS__)
+#define PRINT_NORMAL(...)   SIF_PRINT_AT(SIF_NORMAL, __VA_ARGS__)
+#define PRINT_VERBOSE(...)  SIF_PRINT_AT(SIF_VERBOSE, __VA_ARGS__)
+#define PRINT_DEBUG(...)    SIF_PRINT_AT(SIF_DEBUG, __VA_ARGS__)
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,53 @@
+/*
+ * csif - Andor SIF Parser in C
+ * Copyright (C) 2025 mithgil
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SIF_PREFETCH_H
+#define SIF_PREFETCH_H
+
+#include "sif_parser.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    SIF_PREFETCH_NONE = 0,        // prefetching not enabled
+    SIF_PREFETCH_PREAD = 1,       // synchronous pread per frame, read-ahead only hinted (fallback)
+    SIF_PREFETCH_IO_URING = 2     // asynchronous reads kept in flight through io_uring
+} SifPrefetchBackend;
+
+// Serve frames outside the loaded window through a prefetcher that keeps up
+// to `depth` frame reads in flight ahead of the consumer. Sequential and
+// strided access across sif_get_frame_data calls is detected and followed.
+// Without io_uring (or for a compressed file) each frame is read when asked
+// for; on a plain file the kernel is only advised of the frames ahead
+// (POSIX_FADV_WILLNEED), so a cold disk overlaps less than with the ring.
+// A pointer returned for a prefetched frame stays valid until the next
+// sif_get_frame_data call on the handle; one consumer thread per handle.
+int sif_prefetch_enable(SifFile *sif_file, int depth, int enable_byte_swap);
+void sif_prefetch_disable(SifFile *sif_file);
+SifPrefetchBackend sif_prefetch_backend(const SifFile *sif_file);
+
+// frame lookup used by sif_get_frame_data
+float *sif_prefetch_get_frame(SifFile *sif_file, int frame_index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
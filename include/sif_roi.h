@@ -0,0 +1,58 @@
+/*
+ * csif - Andor SIF Parser in C
+ * Copyright (C) 2025 mithgil
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SIF_ROI_H
+#define SIF_ROI_H
+
+#include "sif_parser.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// A rectangle of one track, in pixels of that track: columns [x0, x1) and
+// rows [y0, y1). An end of 0 stands for the track's width or height, so a
+// column window keeps all rows and a row band keeps all columns.
+typedef struct {
+    int track;                    // subimage, 0 when the file has a single one
+    int x0, x1;
+    int y0, y1;
+} SifRoi;
+
+extern const SifRoi SIF_FULL_ROI;  // all of track 0
+
+// resolved size of the ROI, -1 if it does not fit the track
+int sif_roi_size(const SifFile *sif_file, SifRoi roi, int *width, int *height);
+
+// Read only the ROI of each frame into out, packed row by row: frame_count *
+// width * height floats. Row bands are one contiguous read per frame; column
+// windows are read row by row at the track's stride, with neighbouring rows
+// merged into one read when the gap between them is small. Like
+// sif_read_frames it does not touch the handle and may be called from many
+// threads.
+int sif_read_roi(const SifFile *sif_file, int start_frame, int frame_count, SifRoi roi,
+                 float *out, int enable_byte_swap);
+
+// the ROI of every frame in a new buffer (release with sif_free), NULL on error
+float *sif_load_roi(const SifFile *sif_file, SifRoi roi, int enable_byte_swap, int *width, int *height);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,89 @@
+/*
+ * csif - Andor SIF Parser in C
+ * Copyright (C) 2025 mithgil
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SIF_STATS_H
+#define SIF_STATS_H
+
+#include <stdint.h>
+#include "sif_parser.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    SIF_PHASE_HEADER_PARSE = 0,   // whole sif_open header parse
+    SIF_PHASE_TIMESTAMPS,         // per-frame timestamp lines
+    SIF_PHASE_USER_TEXT,          // reading the user text at open
+    SIF_PHASE_FRAME_READ,         // frame data reads (pread, mapping copies)
+    SIF_PHASE_BYTE_SWAP,          // endian correction of frame data
+    SIF_PHASE_JSON,               // sif_file_to_json
+    SIF_PHASE_CONVERT,            // dtype conversion in sif_read_frames_as
+    SIF_PHASE_CALIBRATION,        // calibration parsed from the user text on first use
+    SIF_PHASE_COUNT
+} SifPhase;
+
+typedef struct {
+    uint64_t calls[SIF_PHASE_COUNT];
+    uint64_t nanoseconds[SIF_PHASE_COUNT];  // wall time per phase (nested phases overlap)
+    uint64_t bytes_read;
+    uint64_t read_calls;          // read requests issued to the file
+    uint64_t seek_calls;
+    uint64_t bytes_allocated;     // header tables and frame buffers
+    uint64_t trace_events;        // events recorded (may exceed the trace capacity)
+} SifStats;
+
+// Counters are only collected in builds with SIF_ENABLE_STATS; otherwise
+// every hook compiles to nothing and sif_get_stats returns -1 with zeros.
+int sif_get_stats(const SifFile *sif_file, SifStats *stats);
+void sif_reset_stats(SifFile *sif_file);
+const char *sif_phase_name(SifPhase phase);
+
+// Record up to max_events phase spans from now on (SifOpenOptions.trace_events
+// does the same from sif_open) and write them as Chrome trace / Perfetto JSON.
+int sif_trace_enable(SifFile *sif_file, size_t max_events);
+int sif_trace_write_json(const SifFile *sif_file, const char *path);
+
+// library hooks
+struct SifStatsState *sif_stats_create(size_t trace_events);
+void sif_stats_destroy(struct SifStatsState *stats);
+uint64_t sif_stats_now(void);
+void sif_stats_record(struct SifStatsState *stats, SifPhase phase, uint64_t start_ns, uint64_t bytes);
+void sif_stats_add_read(struct SifStatsState *stats, uint64_t bytes, int calls);
+void sif_stats_add_seek(struct SifStatsState *stats);
+void sif_stats_add_alloc(struct SifStatsState *stats, uint64_t bytes);
+
+#ifdef SIF_ENABLE_STATS
+#define SIF_STATS_START(var)                        uint64_t var = sif_stats_now()
+#define SIF_STATS_PHASE(stats, phase, start, bytes) sif_stats_record((stats), (phase), (start), (bytes))
+#define SIF_STATS_READ(stats, bytes, calls)         sif_stats_add_read((stats), (bytes), (calls))
+#define SIF_STATS_SEEK(stats)                       sif_stats_add_seek((stats))
+#define SIF_STATS_ALLOC(stats, bytes)               sif_stats_add_alloc((stats), (bytes))
+#else
+#define SIF_STATS_START(var)                        ((void)0)
+#define SIF_STATS_PHASE(stats, phase, start, bytes) ((void)0)
+#define SIF_STATS_READ(stats, bytes, calls)         ((void)0)
+#define SIF_STATS_SEEK(stats)                       ((void)0)
+#define SIF_STATS_ALLOC(stats, bytes)               ((void)0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
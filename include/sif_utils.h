@@ -20,6 +20,7 @@
 #define SIF_UTILS_H
 
 #include <stdio.h>
+#include <sys/types.h>
 #include "sif_parser.h"
 
 // tool functions declaration
@@ -31,11 +32,22 @@ void debug_comprehensive(FILE* fp, long debug_pos, int num_lines, int hex_dump_b
 int32_t read_little_endian_int32(FILE *fp);
 int32_t read_big_endian_int32(FILE *fp);
 
+void swap_float_array_endian(float *data, size_t count);
+void swap_float_array_endian_copy(float *dst, const void *src, size_t count);
+const char *sif_byte_swap_kernel(void);  // "scalar", "ssse3", "avx2", "avx512bw" or "neon"
+ssize_t pread_full(int fd, void *buffer, size_t count, int64_t offset);
+
+// shared, reference-counted copies of metadata strings ("" is never NULL)
+const char *sif_intern(const char *str);
+void sif_intern_release(const char *str);
+
 // These functions need the SifInfo parameter to get the output level.
 void print_sif_first_line(const char *filename, SifInfo *info);
 void print_sif_info_summary(const SifInfo *info);
 void print_sif_file_structure(const SifFile *sif_file);
 void print_hex_dump(FILE *fp, int target_offset, int before_bytes, int after_bytes);
+// NULL when frames x width does not fit calibration_size; extract_calibration
+// reports frames and width separately
 double* retrieve_calibration(SifInfo *info, int* calibration_size);
 
 void sif_utils_set_verbose_level(SifVerboseLevel level); 
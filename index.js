@@ -22,19 +22,27 @@ function parseSifFile(filename) {
  * @returns {Object} 基本信息對象
  */
 function getFileInfo(filename) {
-  const data = parseSifFile(filename);
+  // 只讀取標頭，不載入幀數據
+  let probe;
+  try {
+    probe = addon.sifProbe(filename);
+  } catch (error) {
+    throw new Error(`Failed to read SIF file info '${filename}': ${error.message}`);
+  }
   return {
-    camera: data.metadata.cameraModel,
-    dimensions: data.dimensions,
-    frames: data.metadata.numberOfFrames,
-    exposureTime: data.metadata.exposureTime,
-    dataPoints: data.data.length
+    camera: probe.detectorType,
+    dimensions: { width: probe.width, height: probe.height },
+    frames: probe.numberOfFrames,
+    exposureTime: probe.exposureTime,
+    dataPoints: probe.numberOfFrames * probe.pixelsPerFrame
   };
 }
 
 module.exports = {
   parseSifFile,
   getFileInfo,
+  sifProbe: addon.sifProbe,
+  sifBufferToFloat32: addon.sifBufferToFloat32,
   // 保持向後兼容
   sifFileToJson: addon.sifFileToJson
 };
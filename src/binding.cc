@@ -2,6 +2,7 @@
 #include "sif_parser.h"
 #include "sif_json.h"
 #include "sif_utils.h"
+#include "sif_convert.h"
 #include <stdio.h>
 #include <string.h>
 #include <vector>
@@ -37,7 +38,7 @@ Napi::Value SifFileToJsonWrapped(const Napi::CallbackInfo& info) {
             
             if (json_str) {
                 Napi::String result = Napi::String::New(env, json_str);
-                free(json_str);
+                sif_free(json_str);
                 sif_close(&sif_file);
                 fclose(fp);
                 return result;
@@ -80,45 +81,41 @@ Napi::Value SifFileToBinaryWrapped(const Napi::CallbackInfo& info) {
         return env.Null();
     }
 
-    if (sif_load_all_frames(&sif_file, 0) != 0) {
-        sif_close(&sif_file);
-        fclose(fp);
-        Napi::Error::New(env, "Failed to load frame data").ThrowAsJavaScriptException();
-        return env.Null();
-    }
-
-    sif_file.data_loaded = 1;
-    
     // to obtain sif file info
     int width = sif_file.info.image_width;
     int height = sif_file.info.image_height;
-    int total_frames = sif_file.info.number_of_frames;
-    int pixels_per_frame = width * height;
-    int total_data_points = total_frames * pixels_per_frame;
+    int total_frames = sif_file.frame_count;
+    size_t pixels_per_frame = sif_file.info.pixels_per_frame;
+    size_t total_data_points = (size_t)total_frames * pixels_per_frame;
     
-    printf("=== SIF Binary Export ===\n");
-    printf("Dimensions: %dx%d, Frames: %d\n", width, height, total_frames);
-    printf("Total data points: %d\n", total_data_points);
+    PRINT_VERBOSE("=== SIF Binary Export ===\n");
+    PRINT_VERBOSE("Dimensions: %dx%d, Frames: %d\n", width, height, total_frames);
+    PRINT_VERBOSE("Total data points: %zu\n", total_data_points);
     
     // create ArrayBuffer
     size_t buffer_size = total_data_points * sizeof(double);
     Napi::ArrayBuffer array_buffer = Napi::ArrayBuffer::New(env, buffer_size);
     
-    // get the pointer of the ArrayBuffer 
-    double* buffer_data = static_cast<double*>(array_buffer.Data());
-    
-    // 將 float 數據轉換為 double 並複製到 buffer
-    printf("Copying data from SIF frame_data to ArrayBuffer...\n");
-    
-    for (int i = 0; i < total_data_points; i++) {
-        buffer_data[i] = static_cast<double>(sif_file.frame_data[i]);
+    // 直接讀入並轉換為 double，不經過 float 中間緩衝
+    SifConvertOptions options = SIF_DEFAULT_CONVERT_OPTIONS;
+    options.dtype = SIF_DTYPE_FLOAT64;
+    if (total_frames > 0 &&
+        sif_read_frames_as(&sif_file, 0, total_frames, array_buffer.Data(), options) != 0) {
+        // 截斷的文件：退回整體載入（缺少的像素補零）再轉換
+        if (sif_load_all_frames(&sif_file, 0) != 0 ||
+            sif_convert_pixels(sif_file.frame_data, array_buffer.Data(), total_data_points, options) != 0) {
+            sif_close(&sif_file);
+            fclose(fp);
+            Napi::Error::New(env, "Failed to load frame data").ThrowAsJavaScriptException();
+            return env.Null();
+        }
     }
     
     // 創建 Float64Array
     Napi::TypedArray typed_array = Napi::TypedArrayOf<double>::New(env, 
         total_data_points, array_buffer, 0, napi_float64_array);
     
-    printf("✓ Created Float64Array with %zu bytes\n", buffer_size);
+    PRINT_VERBOSE("✓ Created Float64Array with %zu bytes\n", buffer_size);
     
     // 清理資源
     sif_close(&sif_file);
@@ -149,7 +146,8 @@ Napi::Value SifFileToObjectWrapped(const Napi::CallbackInfo& info) {
     sif_file.data_loaded = 0;
     sif_file.frame_data = NULL;
 
-    if (sif_open(fp, &sif_file) != 0) {
+    // map the file so frames are copied straight from the page cache
+    if (sif_open_mmap(fp, &sif_file) != 0) {
         fclose(fp);
         Napi::Error::New(env, "Failed to open SIF file").ThrowAsJavaScriptException();
         return env.Null();
@@ -168,12 +166,12 @@ Napi::Value SifFileToObjectWrapped(const Napi::CallbackInfo& info) {
     int width = sif_file.info.image_width;
     int height = sif_file.info.image_height;
     int total_frames = sif_file.info.number_of_frames;
-    int pixels_per_frame = width * height;
-    int total_data_points = total_frames * pixels_per_frame;
+    size_t pixels_per_frame = sif_file.info.pixels_per_frame;
+    size_t total_data_points = (size_t)total_frames * pixels_per_frame;
     
-    printf("=== SIF Object Export ===\n");
-    printf("Dimensions: %dx%d, Frames: %d\n", width, height, total_frames);
-    printf("Total data points: %d\n", total_data_points);
+    PRINT_VERBOSE("=== SIF Object Export ===\n");
+    PRINT_VERBOSE("Dimensions: %dx%d, Frames: %d\n", width, height, total_frames);
+    PRINT_VERBOSE("Total data points: %zu\n", total_data_points);
     
     // 創建返回對象
     Napi::Object result = Napi::Object::New(env);
@@ -221,8 +219,26 @@ Napi::Value SifFileToObjectWrapped(const Napi::CallbackInfo& info) {
     metadata.Set("experimentTime", Napi::Number::New(env, sif_file.info.experiment_time));
     metadata.Set("accumulatedCycles", Napi::Number::New(env, sif_file.info.accumulated_cycles));
     metadata.Set("numberOfSubimages", Napi::Number::New(env, sif_file.info.number_of_subimages));
+    metadata.Set("pixelsPerFrame", Napi::Number::New(env, sif_file.info.pixels_per_frame));
+
+    // per-track views into each frame of binaryData
+    if (sif_file.info.subimages) {
+        Napi::Array tracks = Napi::Array::New(env, sif_file.info.number_of_subimages);
+        for (int i = 0; i < sif_file.info.number_of_subimages; i++) {
+            const SubImageInfo *sub = &sif_file.info.subimages[i];
+            Napi::Object track = Napi::Object::New(env);
+            track.Set("offset", Napi::Number::New(env, sub->offset));
+            track.Set("width", Napi::Number::New(env, sub->width));
+            track.Set("height", Napi::Number::New(env, sub->height));
+            track.Set("xbin", Napi::Number::New(env, sub->xbin));
+            track.Set("ybin", Napi::Number::New(env, sub->ybin));
+            tracks.Set((uint32_t)i, track);
+        }
+        metadata.Set("tracks", tracks);
+    }
     
     // 添加校準信息（如果可用）
+    sif_ensure_calibration(&sif_file.info);
     if (sif_file.info.calibration_coeff_count > 0) {
         Napi::Object calibration = Napi::Object::New(env);
         Napi::Array coefficients = Napi::Array::New(env, sif_file.info.calibration_coeff_count);
@@ -248,7 +264,7 @@ Napi::Value SifFileToObjectWrapped(const Napi::CallbackInfo& info) {
     Napi::TypedArray binary_data = Napi::TypedArrayOf<float>::New(env, 
         total_data_points, array_buffer, 0, napi_float32_array);
     
-    printf("✓ Created Float32Array with %zu bytes\n", buffer_size);
+    PRINT_VERBOSE("✓ Created Float32Array with %zu bytes\n", buffer_size);
     
     // 關鍵修復：把 binary_data 設置到返回對象中！
     result.Set("metadata", metadata);
@@ -284,7 +300,7 @@ Napi::Value SifFileToFloat32Wrapped(const Napi::CallbackInfo& info) {
     sif_file.data_loaded = 0;
     sif_file.frame_data = NULL;
 
-    if (sif_open(fp, &sif_file) != 0) {
+    if (sif_open_mmap(fp, &sif_file) != 0) {
         fclose(fp);
         Napi::Error::New(env, "Failed to open SIF file").ThrowAsJavaScriptException();
         return env.Null();
@@ -302,10 +318,10 @@ Napi::Value SifFileToFloat32Wrapped(const Napi::CallbackInfo& info) {
     int width = sif_file.info.image_width;
     int height = sif_file.info.image_height;
     int total_frames = sif_file.info.number_of_frames;
-    int total_data_points = total_frames * width * height;
+    size_t total_data_points = (size_t)total_frames * sif_file.info.pixels_per_frame;
     
-    printf("=== SIF Float32 Export ===\n");
-    printf("Creating Float32Array with %d elements\n", total_data_points);
+    PRINT_VERBOSE("=== SIF Float32 Export ===\n");
+    PRINT_VERBOSE("Creating Float32Array with %zu elements\n", total_data_points);
     
     // 創建 Float32Array（內存減半）
     size_t buffer_size = total_data_points * sizeof(float);
@@ -318,7 +334,7 @@ Napi::Value SifFileToFloat32Wrapped(const Napi::CallbackInfo& info) {
     Napi::TypedArray typed_array = Napi::TypedArrayOf<float>::New(env, 
         total_data_points, array_buffer, 0, napi_float32_array);
     
-    printf("✓ Created Float32Array with %zu bytes\n", buffer_size);
+    PRINT_VERBOSE("✓ Created Float32Array with %zu bytes\n", buffer_size);
     
     sif_close(&sif_file);
     fclose(fp);
@@ -326,6 +342,75 @@ Napi::Value SifFileToFloat32Wrapped(const Napi::CallbackInfo& info) {
     return typed_array;
 }
 
+// Float32Array from SIF bytes already in memory (an upload), no temp file
+Napi::Value SifBufferToFloat32Wrapped(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsBuffer()) {
+        Napi::TypeError::New(env, "Expected SIF file contents (Buffer)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    Napi::Buffer<uint8_t> input = info[0].As<Napi::Buffer<uint8_t>>();
+
+    SifFile sif_file;
+    memset(&sif_file, 0, sizeof(SifFile));
+    if (sif_open_memory(input.Data(), input.Length(), &sif_file) != 0) {
+        Napi::Error::New(env, "Failed to parse SIF data").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    int total_frames = sif_file.frame_count;
+    size_t total_data_points = (size_t)total_frames * sif_file.info.pixels_per_frame;
+
+    // 直接從輸入緩衝區複製到 Float32Array
+    Napi::ArrayBuffer array_buffer = Napi::ArrayBuffer::New(env, total_data_points * sizeof(float));
+    if (total_frames > 0 &&
+        sif_read_frames(&sif_file, 0, total_frames, static_cast<float*>(array_buffer.Data()), 0) != 0) {
+        sif_close(&sif_file);
+        Napi::Error::New(env, "Failed to load frame data").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    Napi::TypedArray typed_array = Napi::TypedArrayOf<float>::New(env,
+        total_data_points, array_buffer, 0, napi_float32_array);
+
+    sif_close(&sif_file);
+    return typed_array;
+}
+
+// header-only summary for file listings, no frame data is read
+Napi::Value SifProbeWrapped(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Expected a filename (string)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    std::string filename = info[0].As<Napi::String>();
+
+    SifProbe probe;
+    if (sif_probe(filename.c_str(), &probe) != 0) {
+        Napi::Error::New(env, "Failed to probe SIF file: " + filename).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("sifVersion", Napi::Number::New(env, probe.sif_version));
+    result.Set("numberOfFrames", Napi::Number::New(env, probe.number_of_frames));
+    result.Set("numberOfSubimages", Napi::Number::New(env, probe.number_of_subimages));
+    result.Set("width", Napi::Number::New(env, probe.image_width));
+    result.Set("height", Napi::Number::New(env, probe.image_height));
+    result.Set("pixelsPerFrame", Napi::Number::New(env, (double)probe.pixels_per_frame));
+    result.Set("exposureTime", Napi::Number::New(env, probe.exposure_time));
+    result.Set("detectorTemperature", Napi::Number::New(env, probe.detector_temperature));
+    result.Set("dataOffset", Napi::Number::New(env, (double)probe.data_offset));
+    result.Set("detectorType", Napi::String::New(env, probe.detector_type));
+
+    return result;
+}
+
 Napi::Object InitAll(Napi::Env env, Napi::Object exports) {
     // 原有 JSON 方法
     exports.Set("sifFileToJson", Napi::Function::New(env, SifFileToJsonWrapped));
@@ -334,6 +419,8 @@ Napi::Object InitAll(Napi::Env env, Napi::Object exports) {
     exports.Set("sifFileToBinary", Napi::Function::New(env, SifFileToBinaryWrapped));
     exports.Set("sifFileToObject", Napi::Function::New(env, SifFileToObjectWrapped));
     exports.Set("sifFileToFloat32", Napi::Function::New(env, SifFileToFloat32Wrapped));
+    exports.Set("sifBufferToFloat32", Napi::Function::New(env, SifBufferToFloat32Wrapped));
+    exports.Set("sifProbe", Napi::Function::New(env, SifProbeWrapped));
     
     return exports;
 }
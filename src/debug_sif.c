@@ -321,27 +321,23 @@ ValidationResult validate_sif_structure(const SifFile *sif_file) {
         }
     }
     
-    // 10. 瓦片數據驗證
-    if (sif_file->tile_count > 0 && sif_file->tiles) {
-        printf("10. Tile Information:\n");
+    // 10. 幀佈局驗證
+    if (sif_file->frame_count > 0) {
+        printf("10. Frame Layout:\n");
         
-        if (sif_file->tile_count != info->number_of_frames) {
-            printf("   ❌ Tile count (%d) doesn't match frame count (%d)\n",
-                   sif_file->tile_count, info->number_of_frames);
+        if (sif_file->frame_count != info->number_of_frames) {
+            printf("   ❌ Frame count (%d) doesn't match header frame count (%d)\n",
+                   sif_file->frame_count, info->number_of_frames);
             error_count++;
         } else {
-            printf("   ✓ Tile count matches frame count: %d\n", sif_file->tile_count);
+            printf("   ✓ Frame count matches header: %d\n", sif_file->frame_count);
         }
         
-        for (int i = 0; i < sif_file->tile_count; i++) {
-            const ImageTile *tile = &sif_file->tiles[i];
-            
-            if (tile->width != info->image_width || tile->height != info->image_height) {
-                printf("   ❌ Tile %d size mismatch: %dx%d vs expected %dx%d\n",
-                       i, tile->width, tile->height, info->image_width, info->image_height);
-                error_count++;
-            }
-        }
+        // frames sit back to back from data_offset
+        int64_t data_end = sif_frame_offset(sif_file, sif_file->frame_count - 1) +
+                           (int64_t)info->pixels_per_frame * (int64_t)sizeof(float);
+        printf("   ✓ Frame data: 0x%08" PRIX64 " - 0x%08" PRIX64 " (%zu pixels per frame)\n",
+               (uint64_t)info->data_offset, (uint64_t)data_end, info->pixels_per_frame);
     }
     
     // 總結
@@ -58,9 +58,9 @@ int main(int argc, char *argv[]) {
             PRINT_NORMAL("\n");
             
             PRINT_NORMAL("Frames: %d, Image size: %dx%d\n", 
-                sif_file.tile_count, 
-                sif_file.tiles[0].width, 
-                sif_file.tiles[0].height);
+                sif_file.frame_count, 
+                sif_file.info.image_width, 
+                sif_file.info.image_height);
 
             //sif_load_all_frames(SifFile *sif_file, int byte_swap)
             if (sif_load_all_frames(&sif_file, 0) ==  0) {
@@ -117,7 +117,7 @@ int main(int argc, char *argv[]) {
                     PRINT_NORMAL("\n");
                 }
                 
-                free(calibration);
+                sif_free(calibration);
             } else {
                 PRINT_NORMAL("No calibration data available\n");
             }
@@ -0,0 +1,352 @@
+/*
+ * csif - Andor SIF Parser in C
+ * Copyright (C) 2025 mithgil
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "sif_alloc.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SIF_ARENA_CHUNK_BYTES (64 << 10)
+#define SIF_ARENA_LARGE_BYTES (16 << 10)  // from here on a block gets its own allocation
+#define SIF_ARENA_ALIGN 16
+
+// directly in front of every arena block
+typedef struct {
+    size_t size;                  // requested bytes
+    size_t large;                 // block is a LargeBlock
+} BlockHeader;
+
+typedef struct LargeBlock {
+    struct LargeBlock *prev;
+    struct LargeBlock *next;
+    BlockHeader header;
+} LargeBlock;
+
+typedef struct ArenaChunk {
+    struct ArenaChunk *next;
+    size_t capacity;              // bytes after the chunk header
+    size_t used;
+    size_t reserved;              // keeps the data 16-byte aligned
+} ArenaChunk;
+
+struct SifAllocState {
+    SifAllocator backing;
+    int use_arena;
+
+    // arena: small blocks are carved from the current chunk, large blocks
+    // are listed so that they can be freed individually
+    pthread_mutex_t lock;
+    ArenaChunk *chunks;           // in allocation order
+    ArenaChunk *current;          // chunks after it are empty (after a rewind)
+    LargeBlock *large;
+};
+
+static void *libc_malloc(size_t size, void *user_data) {
+    (void)user_data;
+    return malloc(size);
+}
+
+static void *libc_realloc(void *ptr, size_t size, void *user_data) {
+    (void)user_data;
+    return realloc(ptr, size);
+}
+
+static void libc_free(void *ptr, void *user_data) {
+    (void)user_data;
+    free(ptr);
+}
+
+static SifAllocator global_allocator = { libc_malloc, libc_realloc, libc_free, NULL };
+static int global_custom = 0;     // plain libc calls while unset
+
+static void *arena_alloc(struct SifAllocState *state, size_t size);
+static void *arena_realloc(struct SifAllocState *state, void *ptr, size_t size);
+static void arena_free(struct SifAllocState *state, void *ptr);
+
+int sif_set_allocator(const SifAllocator *allocator) {
+    if (!allocator) {
+        global_allocator = (SifAllocator){ libc_malloc, libc_realloc, libc_free, NULL };
+        global_custom = 0;
+        return 0;
+    }
+    if (!allocator->malloc_fn || !allocator->realloc_fn || !allocator->free_fn) {
+        return -1;
+    }
+
+    global_allocator = *allocator;
+    global_custom = 1;
+    return 0;
+}
+
+void sif_free(void *ptr) {
+    sif_mem_free(NULL, ptr);
+}
+
+struct SifAllocState *sif_alloc_create(const SifAllocator *allocator, int use_arena) {
+    if (allocator && (!allocator->malloc_fn || !allocator->realloc_fn || !allocator->free_fn)) {
+        return NULL;
+    }
+
+    const SifAllocator backing = allocator ? *allocator : global_allocator;
+    struct SifAllocState *state = backing.malloc_fn(sizeof(struct SifAllocState), backing.user_data);
+    if (!state) return NULL;
+
+    memset(state, 0, sizeof(struct SifAllocState));
+    state->backing = backing;
+    state->use_arena = use_arena;
+    if (use_arena) {
+        pthread_mutex_init(&state->lock, NULL);
+    }
+    return state;
+}
+
+void sif_alloc_destroy(struct SifAllocState *state) {
+    if (!state) return;
+
+    const SifAllocator backing = state->backing;
+    if (state->use_arena) {
+        ArenaChunk *chunk = state->chunks;
+        while (chunk) {
+            ArenaChunk *next = chunk->next;
+            backing.free_fn(chunk, backing.user_data);
+            chunk = next;
+        }
+
+        LargeBlock *block = state->large;
+        while (block) {
+            LargeBlock *next = block->next;
+            backing.free_fn(block, backing.user_data);
+            block = next;
+        }
+        pthread_mutex_destroy(&state->lock);
+    }
+
+    backing.free_fn(state, backing.user_data);
+}
+
+void *sif_mem_alloc(struct SifAllocState *state, size_t size) {
+    if (state) {
+        if (state->use_arena) return arena_alloc(state, size);
+        return state->backing.malloc_fn(size, state->backing.user_data);
+    }
+    if (!global_custom) return malloc(size);
+    return global_allocator.malloc_fn(size, global_allocator.user_data);
+}
+
+void *sif_mem_calloc(struct SifAllocState *state, size_t count, size_t size) {
+    if (!state && !global_custom) return calloc(count, size);
+    if (size != 0 && count > SIZE_MAX / size) return NULL;
+
+    void *ptr = sif_mem_alloc(state, count * size);
+    if (ptr) memset(ptr, 0, count * size);
+    return ptr;
+}
+
+void *sif_mem_realloc(struct SifAllocState *state, void *ptr, size_t size) {
+    if (state) {
+        if (state->use_arena) return arena_realloc(state, ptr, size);
+        return state->backing.realloc_fn(ptr, size, state->backing.user_data);
+    }
+    if (!global_custom) return realloc(ptr, size);
+    return global_allocator.realloc_fn(ptr, size, global_allocator.user_data);
+}
+
+void sif_mem_free(struct SifAllocState *state, void *ptr) {
+    if (!ptr) return;
+    if (state) {
+        if (state->use_arena) {
+            arena_free(state, ptr);
+        } else {
+            state->backing.free_fn(ptr, state->backing.user_data);
+        }
+        return;
+    }
+    if (!global_custom) {
+        free(ptr);
+        return;
+    }
+    global_allocator.free_fn(ptr, global_allocator.user_data);
+}
+
+char *sif_mem_strdup(struct SifAllocState *state, const char *str) {
+    if (!str) return NULL;
+
+    size_t length = strlen(str) + 1;
+    char *copy = sif_mem_alloc(state, length);
+    if (copy) memcpy(copy, str, length);
+    return copy;
+}
+
+static size_t block_span(size_t size) {
+    return (sizeof(BlockHeader) + size + SIF_ARENA_ALIGN - 1) & ~(size_t)(SIF_ARENA_ALIGN - 1);
+}
+
+static unsigned char *chunk_data(ArenaChunk *chunk) {
+    return (unsigned char *)(chunk + 1);
+}
+
+static BlockHeader *header_of(void *ptr) {
+    return (BlockHeader *)ptr - 1;
+}
+
+// the arena functions below run with state->lock held
+
+static void *large_alloc(struct SifAllocState *state, size_t size) {
+    if (size > SIZE_MAX - sizeof(LargeBlock)) return NULL;
+
+    LargeBlock *block = state->backing.malloc_fn(sizeof(LargeBlock) + size, state->backing.user_data);
+    if (!block) return NULL;
+
+    block->header.size = size;
+    block->header.large = 1;
+    block->prev = NULL;
+    block->next = state->large;
+    if (state->large) state->large->prev = block;
+    state->large = block;
+    return block + 1;
+}
+
+static void large_unlink(struct SifAllocState *state, LargeBlock *block) {
+    if (block->prev) block->prev->next = block->next;
+    else state->large = block->next;
+    if (block->next) block->next->prev = block->prev;
+}
+
+static void large_link(struct SifAllocState *state, LargeBlock *block) {
+    block->prev = NULL;
+    block->next = state->large;
+    if (state->large) state->large->prev = block;
+    state->large = block;
+}
+
+static void *small_alloc(struct SifAllocState *state, size_t size) {
+    size_t span = block_span(size);
+    ArenaChunk *chunk = state->current;
+
+    if (!chunk || chunk->capacity - chunk->used < span) {
+        // the rest of the old chunk is given up
+        if (chunk && chunk->next) {
+            chunk = chunk->next;
+        } else {
+            ArenaChunk *fresh = state->backing.malloc_fn(sizeof(ArenaChunk) + SIF_ARENA_CHUNK_BYTES,
+                                                         state->backing.user_data);
+            if (!fresh) return NULL;
+            fresh->capacity = SIF_ARENA_CHUNK_BYTES;
+            fresh->next = NULL;
+            if (chunk) chunk->next = fresh;
+            else state->chunks = fresh;
+            chunk = fresh;
+        }
+        chunk->used = 0;
+        state->current = chunk;
+    }
+
+    BlockHeader *header = (BlockHeader *)(chunk_data(chunk) + chunk->used);
+    chunk->used += span;
+    header->size = size;
+    header->large = 0;
+    return header + 1;
+}
+
+// is this small block the last one carved from the current chunk?
+static int is_chunk_top(struct SifAllocState *state, BlockHeader *header) {
+    ArenaChunk *chunk = state->current;
+    if (!chunk) return 0;
+
+    unsigned char *start = (unsigned char *)header;
+    return start >= chunk_data(chunk) && start + block_span(header->size) == chunk_data(chunk) + chunk->used;
+}
+
+static void *arena_alloc(struct SifAllocState *state, size_t size) {
+    pthread_mutex_lock(&state->lock);
+    void *ptr = size >= SIF_ARENA_LARGE_BYTES ? large_alloc(state, size) : small_alloc(state, size);
+    pthread_mutex_unlock(&state->lock);
+    return ptr;
+}
+
+// small blocks are only reclaimed when they are the most recent allocation
+static void arena_free(struct SifAllocState *state, void *ptr) {
+    BlockHeader *header = header_of(ptr);
+
+    pthread_mutex_lock(&state->lock);
+    if (header->large) {
+        LargeBlock *block = (LargeBlock *)ptr - 1;
+        large_unlink(state, block);
+        state->backing.free_fn(block, state->backing.user_data);
+    } else if (is_chunk_top(state, header)) {
+        state->current->used -= block_span(header->size);
+    }
+    pthread_mutex_unlock(&state->lock);
+}
+
+static void *arena_realloc(struct SifAllocState *state, void *ptr, size_t size) {
+    if (!ptr) return arena_alloc(state, size);
+
+    BlockHeader *header = header_of(ptr);
+    void *result = NULL;
+
+    pthread_mutex_lock(&state->lock);
+    if (header->large) {
+        LargeBlock *block = (LargeBlock *)ptr - 1;
+        large_unlink(state, block);
+        LargeBlock *moved = size <= SIZE_MAX - sizeof(LargeBlock)
+            ? state->backing.realloc_fn(block, sizeof(LargeBlock) + size, state->backing.user_data)
+            : NULL;
+        if (moved) {
+            moved->header.size = size;
+            block = moved;
+            result = moved + 1;
+        }
+        large_link(state, block);
+    } else if (size < SIF_ARENA_LARGE_BYTES && block_span(size) <= block_span(header->size)) {
+        header->size = size;
+        result = ptr;
+    } else if (size < SIF_ARENA_LARGE_BYTES && is_chunk_top(state, header) &&
+               state->current->capacity - state->current->used >= block_span(size) - block_span(header->size)) {
+        // grow in place at the top of the chunk
+        state->current->used += block_span(size) - block_span(header->size);
+        header->size = size;
+        result = ptr;
+    } else {
+        size_t old_size = header->size;
+        result = size >= SIF_ARENA_LARGE_BYTES ? large_alloc(state, size) : small_alloc(state, size);
+        if (result) {
+            memcpy(result, ptr, old_size < size ? old_size : size);
+        }
+    }
+    pthread_mutex_unlock(&state->lock);
+
+    return result;
+}
+
+void sif_alloc_rewind(struct SifAllocState *state) {
+    if (!state || !state->use_arena) return;
+
+    pthread_mutex_lock(&state->lock);
+    for (ArenaChunk *chunk = state->chunks; chunk; chunk = chunk->next) {
+        chunk->used = 0;
+    }
+    state->current = state->chunks;
+    pthread_mutex_unlock(&state->lock);
+}
+
+int sif_mem_survives_rewind(struct SifAllocState *state, const void *ptr) {
+    if (!state || !state->use_arena || !ptr) return 1;
+    return (int)((const BlockHeader *)ptr - 1)->large;
+}
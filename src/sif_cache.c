@@ -0,0 +1,280 @@
+/*
+ * csif - Andor SIF Parser in C
+ * Copyright (C) 2025 mithgil
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#define _POSIX_C_SOURCE 200809L  // pread
+
+#include "sif_cache.h"
+#include "sif_utils.h"
+#include "sif_stats.h"
+#include <errno.h>
+#include <pthread.h>
+
+typedef enum {
+    ENTRY_FREE = 0,
+    ENTRY_LOADING,                // being read by the thread that missed
+    ENTRY_READY
+} EntryState;
+
+typedef struct {
+    float *data;
+    int frame_index;
+    EntryState state;
+    int pins;                     // outstanding acquires
+    int referenced;               // CLOCK bit, set on every hit
+} CacheEntry;
+
+struct SifFrameCache {
+    int enable_byte_swap;
+    size_t frame_size;
+    size_t budget_bytes;
+    struct SifStatsState *stats;  // the handle's counters, NULL when not counting
+    struct SifAllocState *alloc;  // the handle's allocator
+
+    CacheEntry *entries;
+    int capacity;
+    int *entry_of_frame;          // frame index -> entry, -1 if not cached
+    int frame_count;
+    int hand;                     // CLOCK hand
+
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    int frames_cached;
+
+    pthread_mutex_t lock;
+    pthread_cond_t loaded;
+};
+
+static int claim_entry(struct SifFrameCache *cache);
+
+// CLOCK sweep for an unpinned entry, giving referenced ones a second
+// chance; the caller holds the lock
+static int claim_entry(struct SifFrameCache *cache) {
+    for (int step = 0; step < 2 * cache->capacity; step++) {
+        int index = cache->hand;
+        CacheEntry *entry = &cache->entries[index];
+        cache->hand = (cache->hand + 1) % cache->capacity;
+
+        if (entry->state == ENTRY_FREE) {
+            if (!entry->data) {
+                entry->data = sif_mem_alloc(cache->alloc, cache->frame_size * sizeof(float));
+                if (!entry->data) return -1;
+                SIF_STATS_ALLOC(cache->stats, cache->frame_size * sizeof(float));
+            }
+            return index;
+        }
+        if (entry->state == ENTRY_LOADING || entry->pins > 0) continue;
+        if (entry->referenced) {
+            entry->referenced = 0;
+            continue;
+        }
+
+        cache->entry_of_frame[entry->frame_index] = -1;
+        entry->state = ENTRY_FREE;
+        cache->frames_cached--;
+        cache->evictions++;
+        return index;
+    }
+
+    return -1;
+}
+
+int sif_cache_enable(SifFile *sif_file, size_t budget_bytes, int enable_byte_swap) {
+    if (!sif_file || !sif_file->file_ptr || sif_file->frame_count == 0 || sif_file->info.pixels_per_frame == 0) {
+        return -1;
+    }
+
+    if (sif_file->cache) {
+        sif_cache_disable(sif_file);
+    }
+
+    struct SifFrameCache *cache = sif_mem_calloc(sif_file->info.alloc, 1, sizeof(struct SifFrameCache));
+    if (!cache) return -1;
+
+    cache->alloc = sif_file->info.alloc;
+    cache->enable_byte_swap = enable_byte_swap;
+    cache->frame_size = (size_t)sif_file->info.pixels_per_frame;
+    cache->budget_bytes = budget_bytes;
+    cache->stats = sif_file->stats;
+    cache->frame_count = sif_file->frame_count;
+
+    // frame buffers are allocated on first use, so a generous budget is cheap
+    size_t frame_bytes = cache->frame_size * sizeof(float);
+    size_t capacity = frame_bytes > 0 ? budget_bytes / frame_bytes : 0;
+    if (capacity < 1) capacity = 1;
+    if (capacity > (size_t)sif_file->frame_count) capacity = (size_t)sif_file->frame_count;
+    cache->capacity = (int)capacity;
+
+    cache->entries = sif_mem_calloc(cache->alloc, cache->capacity, sizeof(CacheEntry));
+    cache->entry_of_frame = sif_mem_alloc(cache->alloc, sif_file->frame_count * sizeof(int));
+    if (!cache->entries || !cache->entry_of_frame) {
+        PRINT_SILENT("❌ Failed to allocate memory\n");
+        sif_mem_free(cache->alloc, cache->entries);
+        sif_mem_free(cache->alloc, cache->entry_of_frame);
+        sif_mem_free(cache->alloc, cache);
+        return -1;
+    }
+    for (int i = 0; i < sif_file->frame_count; i++) {
+        cache->entry_of_frame[i] = -1;
+    }
+
+    pthread_mutex_init(&cache->lock, NULL);
+    pthread_cond_init(&cache->loaded, NULL);
+
+    sif_file->cache = cache;
+    PRINT_VERBOSE("✓ Frame cache enabled: %d frame(s), %zu bytes budget\n", cache->capacity, budget_bytes);
+    return 0;
+}
+
+void sif_cache_disable(SifFile *sif_file) {
+    if (!sif_file || !sif_file->cache) return;
+
+    struct SifFrameCache *cache = sif_file->cache;
+
+    pthread_mutex_destroy(&cache->lock);
+    pthread_cond_destroy(&cache->loaded);
+    for (int i = 0; i < cache->capacity; i++) {
+        sif_mem_free(cache->alloc, cache->entries[i].data);
+    }
+    sif_mem_free(cache->alloc, cache->entries);
+    sif_mem_free(cache->alloc, cache->entry_of_frame);
+    sif_mem_free(cache->alloc, cache);
+
+    sif_file->cache = NULL;
+}
+
+const float *sif_cache_acquire(SifFile *sif_file, int frame_index) {
+    if (!sif_file || !sif_file->cache || frame_index < 0 || frame_index >= sif_file->frame_count) {
+        return NULL;
+    }
+
+    struct SifFrameCache *cache = sif_file->cache;
+    pthread_mutex_lock(&cache->lock);
+
+    int index;
+    while ((index = cache->entry_of_frame[frame_index]) >= 0 &&
+           cache->entries[index].state == ENTRY_LOADING) {
+        pthread_cond_wait(&cache->loaded, &cache->lock);
+    }
+
+    if (index >= 0) {
+        CacheEntry *entry = &cache->entries[index];
+        entry->pins++;
+        entry->referenced = 1;
+        cache->hits++;
+        pthread_mutex_unlock(&cache->lock);
+        return entry->data;
+    }
+
+    cache->misses++;
+    const SifLogSink *previous_log = sif_log_enter(&sif_file->info);
+    index = claim_entry(cache);
+    if (index < 0) {
+        pthread_mutex_unlock(&cache->lock);
+        PRINT_SILENT("⚠️ Frame cache: no unpinned slot for frame %d\n", frame_index);
+        sif_log_leave(previous_log);
+        return NULL;
+    }
+
+    CacheEntry *entry = &cache->entries[index];
+    entry->frame_index = frame_index;
+    entry->state = ENTRY_LOADING;
+    entry->pins = 1;
+    entry->referenced = 1;
+    cache->entry_of_frame[frame_index] = index;
+    cache->frames_cached++;
+    pthread_mutex_unlock(&cache->lock);
+
+    // read outside the lock, other lookups carry on meanwhile
+    size_t frame_bytes = cache->frame_size * sizeof(float);
+    SIF_STATS_START(read_start);
+    int64_t got = sif_read_at(sif_file, entry->data, frame_bytes, sif_frame_offset(sif_file, frame_index));
+    SIF_STATS_READ(sif_file->stats, got < 0 ? 0 : (uint64_t)got, 1);
+    SIF_STATS_PHASE(sif_file->stats, SIF_PHASE_FRAME_READ, read_start, got < 0 ? 0 : (uint64_t)got);
+    if (got >= 0 && (size_t)got < frame_bytes) {
+        PRINT_SILENT("⚠️ Frame %d: Only read %zu/%zu pixels\n", frame_index,
+               (size_t)got / sizeof(float), cache->frame_size);
+        memset((unsigned char *)entry->data + got, 0, frame_bytes - (size_t)got);
+    }
+    if (got >= 0 && cache->enable_byte_swap) {
+        SIF_STATS_START(swap_start);
+        swap_float_array_endian(entry->data, cache->frame_size);
+        SIF_STATS_PHASE(sif_file->stats, SIF_PHASE_BYTE_SWAP, swap_start, frame_bytes);
+    }
+
+    pthread_mutex_lock(&cache->lock);
+    if (got < 0) {
+        PRINT_SILENT("❌ Read error on frame %d: %s\n", frame_index, strerror(errno));
+        cache->entry_of_frame[frame_index] = -1;
+        entry->state = ENTRY_FREE;
+        entry->pins = 0;
+        cache->frames_cached--;
+    } else {
+        entry->state = ENTRY_READY;
+    }
+    pthread_cond_broadcast(&cache->loaded);
+    pthread_mutex_unlock(&cache->lock);
+    sif_log_leave(previous_log);
+
+    return got < 0 ? NULL : entry->data;
+}
+
+void sif_cache_release(SifFile *sif_file, int frame_index) {
+    if (!sif_file || !sif_file->cache || frame_index < 0 || frame_index >= sif_file->frame_count) {
+        return;
+    }
+
+    struct SifFrameCache *cache = sif_file->cache;
+    pthread_mutex_lock(&cache->lock);
+
+    int index = cache->entry_of_frame[frame_index];
+    if (index >= 0 && cache->entries[index].pins > 0) {
+        cache->entries[index].pins--;
+    }
+
+    pthread_mutex_unlock(&cache->lock);
+}
+
+int sif_cache_copy_frame(SifFile *sif_file, int frame_index, float *output_buffer) {
+    if (!output_buffer) return -1;
+
+    const float *frame = sif_cache_acquire(sif_file, frame_index);
+    if (!frame) return -1;
+
+    memcpy(output_buffer, frame, sif_file->cache->frame_size * sizeof(float));
+    sif_cache_release(sif_file, frame_index);
+    return 0;
+}
+
+void sif_cache_get_stats(SifFile *sif_file, SifCacheStats *stats) {
+    if (!stats) return;
+    memset(stats, 0, sizeof(SifCacheStats));
+    if (!sif_file || !sif_file->cache) return;
+
+    struct SifFrameCache *cache = sif_file->cache;
+    pthread_mutex_lock(&cache->lock);
+
+    stats->hits = cache->hits;
+    stats->misses = cache->misses;
+    stats->evictions = cache->evictions;
+    stats->frames_cached = cache->frames_cached;
+    stats->bytes_used = (size_t)cache->frames_cached * cache->frame_size * sizeof(float);
+    stats->budget_bytes = cache->budget_bytes;
+
+    pthread_mutex_unlock(&cache->lock);
+}
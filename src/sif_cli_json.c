@@ -59,7 +59,7 @@ int main(int argc, char *argv[]) {
         // 只輸出純 JSON，沒有任何其他輸出
         printf("%s", json);
         fflush(stdout);
-        free(json);
+        sif_free(json);
     } else {
         fprintf(stderr, "Error: Failed to generate JSON\n");
     }
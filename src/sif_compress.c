@@ -0,0 +1,480 @@
+/*
+ * csif - Andor SIF Parser in C
+ * Copyright (C) 2025 mithgil
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#define _POSIX_C_SOURCE 200809L  // fileno, pread
+
+#include "sif_compress.h"
+#include "sif_utils.h"
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef SIF_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef SIF_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#define SIF_DECODER_INPUT_BYTES (128 << 10)
+#define SIF_DECODER_SKIP_BYTES (64 << 10)   // scratch for data decoded only to be stepped over
+
+#define ZSTD_FRAME_MAGIC 0xFD2FB528u
+#define ZSTD_SEEK_TABLE_MAGIC 0x184D2A5Eu  // skippable frame holding the seek table
+#define ZSTD_SEEKABLE_MAGIC 0x8F92EAB1u
+#define ZSTD_SEEK_FOOTER_BYTES 9
+
+// one independently compressed frame of a seekable zstd archive
+typedef struct {
+    int64_t compressed_offset;    // file offset
+    int64_t offset;               // decompressed offset of its first byte
+    uint32_t compressed_size;
+    uint32_t size;
+} SeekEntry;
+
+struct SifDecoder {
+    SifCompression compression;
+    int fd;
+    int64_t start;                // file offset where the compressed data begins
+    struct SifAllocState *alloc;
+    pthread_mutex_t lock;         // one decoding position shared by all readers
+
+    // streaming (gzip, plain zstd): the stream has produced `position` bytes
+    int64_t position;
+    int64_t input_offset;         // next compressed byte to read
+    unsigned char *input;
+    size_t input_length;
+    size_t input_pos;
+    int finished;                 // no more output
+    unsigned char *skip;          // SIF_DECODER_SKIP_BYTES
+#ifdef SIF_HAVE_ZLIB
+    z_stream z;
+    int z_ready;
+#endif
+#ifdef SIF_HAVE_ZSTD
+    ZSTD_DStream *zstd;
+    ZSTD_DCtx *dctx;              // seekable archives, one frame at a time
+#endif
+
+    // seekable zstd: the last decoded frame is kept for neighbouring reads
+    SeekEntry *frames;
+    int frame_count;
+    unsigned char *frame_data;
+    size_t frame_capacity;
+    int cached_frame;
+};
+
+static int stream_reset(struct SifDecoder *decoder);
+static int64_t stream_decode(struct SifDecoder *decoder, unsigned char *dst, size_t count);
+static int64_t stream_pread(struct SifDecoder *decoder, unsigned char *dst, size_t count, int64_t offset);
+static int load_seek_table(struct SifDecoder *decoder);
+static int64_t seekable_pread(struct SifDecoder *decoder, unsigned char *dst, size_t count, int64_t offset);
+
+static uint32_t read_le32(const unsigned char *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+SifCompression sif_detect_compression(const unsigned char *head, size_t length) {
+    if (!head) return SIF_COMPRESSION_NONE;
+    if (length >= 2 && head[0] == 0x1f && head[1] == 0x8b) {
+        return SIF_COMPRESSION_GZIP;
+    }
+    if (length >= 4 && read_le32(head) == ZSTD_FRAME_MAGIC) {
+        return SIF_COMPRESSION_ZSTD;
+    }
+    return SIF_COMPRESSION_NONE;
+}
+
+const char *sif_compression_name(SifCompression compression) {
+    switch (compression) {
+        case SIF_COMPRESSION_GZIP: return "gzip";
+        case SIF_COMPRESSION_ZSTD: return "zstd";
+        case SIF_COMPRESSION_ZSTD_SEEKABLE: return "zstd-seekable";
+        default: return "none";
+    }
+}
+
+int sif_compression_supported(SifCompression compression) {
+    switch (compression) {
+        case SIF_COMPRESSION_NONE:
+            return 1;
+        case SIF_COMPRESSION_GZIP:
+#ifdef SIF_HAVE_ZLIB
+            return 1;
+#else
+            return 0;
+#endif
+        case SIF_COMPRESSION_ZSTD:
+        case SIF_COMPRESSION_ZSTD_SEEKABLE:
+#ifdef SIF_HAVE_ZSTD
+            return 1;
+#else
+            return 0;
+#endif
+    }
+    return 0;
+}
+
+SifCompression sif_get_compression(const SifFile *sif_file) {
+    if (!sif_file || !sif_file->decoder) return SIF_COMPRESSION_NONE;
+    return sif_decoder_compression(sif_file->decoder);
+}
+
+SifCompression sif_decoder_compression(const struct SifDecoder *decoder) {
+    return decoder ? decoder->compression : SIF_COMPRESSION_NONE;
+}
+
+#ifdef SIF_HAVE_ZLIB
+// zlib's state comes from the handle's allocator too
+static voidpf zlib_alloc(voidpf opaque, uInt items, uInt size) {
+    return sif_mem_calloc(opaque, items, size);
+}
+
+static void zlib_free(voidpf opaque, voidpf address) {
+    sif_mem_free(opaque, address);
+}
+#endif
+
+struct SifDecoder *sif_decoder_open(FILE *fp, SifCompression compression, struct SifAllocState *alloc) {
+    if (!fp || !sif_compression_supported(compression) || compression == SIF_COMPRESSION_NONE) {
+        return NULL;
+    }
+
+    struct SifDecoder *decoder = sif_mem_calloc(alloc, 1, sizeof(struct SifDecoder));
+    if (!decoder) return NULL;
+
+    decoder->compression = compression;
+    decoder->fd = fileno(fp);
+    decoder->start = ftell(fp);
+    if (decoder->start < 0) decoder->start = 0;
+    decoder->alloc = alloc;
+    decoder->cached_frame = -1;
+    pthread_mutex_init(&decoder->lock, NULL);
+
+    if (compression == SIF_COMPRESSION_ZSTD && load_seek_table(decoder) == 0) {
+        decoder->compression = SIF_COMPRESSION_ZSTD_SEEKABLE;
+#ifdef SIF_HAVE_ZSTD
+        decoder->dctx = ZSTD_createDCtx();
+        if (!decoder->dctx) {
+            sif_decoder_close(decoder);
+            return NULL;
+        }
+#endif
+        return decoder;
+    }
+
+    decoder->input = sif_mem_alloc(alloc, SIF_DECODER_INPUT_BYTES);
+    decoder->skip = sif_mem_alloc(alloc, SIF_DECODER_SKIP_BYTES);
+    if (!decoder->input || !decoder->skip || stream_reset(decoder) != 0) {
+        sif_decoder_close(decoder);
+        return NULL;
+    }
+    return decoder;
+}
+
+void sif_decoder_close(struct SifDecoder *decoder) {
+    if (!decoder) return;
+
+#ifdef SIF_HAVE_ZLIB
+    if (decoder->z_ready) inflateEnd(&decoder->z);
+#endif
+#ifdef SIF_HAVE_ZSTD
+    ZSTD_freeDStream(decoder->zstd);
+    ZSTD_freeDCtx(decoder->dctx);
+#endif
+    pthread_mutex_destroy(&decoder->lock);
+
+    struct SifAllocState *alloc = decoder->alloc;
+    sif_mem_free(alloc, decoder->input);
+    sif_mem_free(alloc, decoder->skip);
+    sif_mem_free(alloc, decoder->frames);
+    sif_mem_free(alloc, decoder->frame_data);
+    sif_mem_free(alloc, decoder);
+}
+
+int64_t sif_decoder_pread(struct SifDecoder *decoder, void *dst, size_t count, int64_t offset) {
+    if (!decoder || !dst || offset < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    pthread_mutex_lock(&decoder->lock);
+    int64_t got = decoder->compression == SIF_COMPRESSION_ZSTD_SEEKABLE
+        ? seekable_pread(decoder, dst, count, offset)
+        : stream_pread(decoder, dst, count, offset);
+    pthread_mutex_unlock(&decoder->lock);
+    return got;
+}
+
+// back to the first byte of the stream
+static int stream_reset(struct SifDecoder *decoder) {
+    decoder->position = 0;
+    decoder->input_offset = decoder->start;
+    decoder->input_length = decoder->input_pos = 0;
+    decoder->finished = 0;
+
+#ifdef SIF_HAVE_ZLIB
+    if (decoder->compression == SIF_COMPRESSION_GZIP) {
+        if (decoder->z_ready) {
+            return inflateReset(&decoder->z) == Z_OK ? 0 : -1;
+        }
+        memset(&decoder->z, 0, sizeof(z_stream));
+        decoder->z.zalloc = zlib_alloc;
+        decoder->z.zfree = zlib_free;
+        decoder->z.opaque = decoder->alloc;
+        if (inflateInit2(&decoder->z, 15 + 16) != Z_OK) return -1;
+        decoder->z_ready = 1;
+        return 0;
+    }
+#endif
+#ifdef SIF_HAVE_ZSTD
+    if (decoder->compression == SIF_COMPRESSION_ZSTD) {
+        if (!decoder->zstd) {
+            decoder->zstd = ZSTD_createDStream();
+            if (!decoder->zstd) return -1;
+        }
+        return ZSTD_isError(ZSTD_initDStream(decoder->zstd)) ? -1 : 0;
+    }
+#endif
+    return -1;
+}
+
+// next block of compressed input once the current one is used up;
+// returns the bytes available, 0 at the end of the file
+static int64_t stream_input(struct SifDecoder *decoder) {
+    if (decoder->input_pos < decoder->input_length) {
+        return (int64_t)(decoder->input_length - decoder->input_pos);
+    }
+
+    ssize_t got = pread_full(decoder->fd, decoder->input, SIF_DECODER_INPUT_BYTES, decoder->input_offset);
+    if (got < 0) return -1;
+
+    decoder->input_offset += got;
+    decoder->input_length = (size_t)got;
+    decoder->input_pos = 0;
+    return got;
+}
+
+// decode up to count bytes from the current position; fewer only at the end
+static int64_t stream_decode(struct SifDecoder *decoder, unsigned char *dst, size_t count) {
+    size_t produced = 0;
+
+    while (produced < count && !decoder->finished) {
+        int64_t available = stream_input(decoder);
+        if (available < 0) return -1;
+        if (available == 0) {
+            // end of the file (a truncated stream just ends early)
+            decoder->finished = 1;
+            break;
+        }
+
+#ifdef SIF_HAVE_ZLIB
+        if (decoder->compression == SIF_COMPRESSION_GZIP) {
+            z_stream *z = &decoder->z;
+            size_t want = count - produced;
+            z->next_in = decoder->input + decoder->input_pos;
+            z->avail_in = (uInt)available;
+            z->next_out = dst + produced;
+            z->avail_out = want > UINT_MAX ? UINT_MAX : (uInt)want;
+
+            int rc = inflate(z, Z_NO_FLUSH);
+            size_t member_output = (size_t)(z->next_out - (dst + produced));
+            decoder->input_pos = (size_t)(z->next_in - decoder->input);
+            produced += member_output;
+
+            if (rc == Z_STREAM_END) {
+                // concatenated members (pigz, appended archives) continue the stream
+                inflateReset(z);
+            } else if (rc == Z_DATA_ERROR && z->total_in == 0 && decoder->position + (int64_t)produced > 0) {
+                // padding after the last member
+                decoder->finished = 1;
+            } else if (rc != Z_OK && rc != Z_BUF_ERROR) {
+                errno = EIO;
+                return -1;
+            }
+            continue;
+        }
+#endif
+#ifdef SIF_HAVE_ZSTD
+        if (decoder->compression == SIF_COMPRESSION_ZSTD) {
+            ZSTD_inBuffer in = { decoder->input, decoder->input_length, decoder->input_pos };
+            ZSTD_outBuffer out = { dst, count, produced };
+            size_t rc = ZSTD_decompressStream(decoder->zstd, &out, &in);
+            if (ZSTD_isError(rc)) {
+                errno = EIO;
+                return -1;
+            }
+            decoder->input_pos = in.pos;
+            produced = out.pos;
+            continue;
+        }
+#endif
+        errno = ENOTSUP;
+        return -1;
+    }
+
+    decoder->position += (int64_t)produced;
+    return (int64_t)produced;
+}
+
+static int64_t stream_pread(struct SifDecoder *decoder, unsigned char *dst, size_t count, int64_t offset) {
+    // a stream only runs forwards: start over for anything behind it
+    if (offset < decoder->position && stream_reset(decoder) != 0) {
+        errno = EIO;
+        return -1;
+    }
+
+    while (decoder->position < offset) {
+        int64_t gap = offset - decoder->position;
+        size_t want = gap < SIF_DECODER_SKIP_BYTES ? (size_t)gap : SIF_DECODER_SKIP_BYTES;
+        int64_t got = stream_decode(decoder, decoder->skip, want);
+        if (got < 0) return -1;
+        if (got == 0) return 0;  // offset past the end
+    }
+
+    return stream_decode(decoder, dst, count);
+}
+
+// The seekable format ends in a skippable frame holding one entry per
+// compressed frame, {compressed size, decompressed size[, checksum]}, and a
+// footer {frame count, descriptor, magic}. Anything inconsistent falls back
+// to streaming.
+static int load_seek_table(struct SifDecoder *decoder) {
+    struct stat st;
+    if (fstat(decoder->fd, &st) != 0 || st.st_size < decoder->start + ZSTD_SEEK_FOOTER_BYTES + 8) {
+        return -1;
+    }
+
+    unsigned char footer[ZSTD_SEEK_FOOTER_BYTES];
+    int64_t footer_offset = (int64_t)st.st_size - ZSTD_SEEK_FOOTER_BYTES;
+    if (pread_full(decoder->fd, footer, sizeof(footer), footer_offset) != (ssize_t)sizeof(footer) ||
+        read_le32(footer + 5) != ZSTD_SEEKABLE_MAGIC || (footer[4] & 0x7c) != 0) {
+        return -1;
+    }
+
+    uint32_t frame_count = read_le32(footer);
+    size_t entry_bytes = (footer[4] & 0x80) ? 12 : 8;
+    int64_t table_bytes = (int64_t)frame_count * (int64_t)entry_bytes;
+    int64_t table_offset = footer_offset - table_bytes;
+    int64_t frame_offset = table_offset - 8;  // skippable frame header
+    if (frame_count == 0 || frame_count > INT_MAX || frame_offset < decoder->start) {
+        return -1;
+    }
+
+    unsigned char header[8];
+    if (pread_full(decoder->fd, header, sizeof(header), frame_offset) != (ssize_t)sizeof(header) ||
+        read_le32(header) != ZSTD_SEEK_TABLE_MAGIC ||
+        read_le32(header + 4) != (uint64_t)table_bytes + ZSTD_SEEK_FOOTER_BYTES) {
+        return -1;
+    }
+
+    unsigned char *table = sif_mem_alloc(decoder->alloc, (size_t)table_bytes);
+    SeekEntry *frames = sif_mem_alloc(decoder->alloc, frame_count * sizeof(SeekEntry));
+    if (!table || !frames ||
+        pread_full(decoder->fd, table, (size_t)table_bytes, table_offset) != (ssize_t)table_bytes) {
+        sif_mem_free(decoder->alloc, table);
+        sif_mem_free(decoder->alloc, frames);
+        return -1;
+    }
+
+    int64_t compressed_offset = decoder->start;
+    int64_t offset = 0;
+    uint32_t largest = 0;
+    for (uint32_t i = 0; i < frame_count; i++) {
+        frames[i].compressed_offset = compressed_offset;
+        frames[i].offset = offset;
+        frames[i].compressed_size = read_le32(table + i * entry_bytes);
+        frames[i].size = read_le32(table + i * entry_bytes + 4);
+        compressed_offset += frames[i].compressed_size;
+        offset += frames[i].size;
+        if (frames[i].size > largest) largest = frames[i].size;
+    }
+    sif_mem_free(decoder->alloc, table);
+
+    // the frames must fill the space up to the seek table exactly
+    if (compressed_offset != frame_offset) {
+        sif_mem_free(decoder->alloc, frames);
+        return -1;
+    }
+
+    decoder->frames = frames;
+    decoder->frame_count = (int)frame_count;
+    decoder->frame_capacity = largest;
+    return 0;
+}
+
+// decode compressed frame `index` into frame_data
+static int decode_frame(struct SifDecoder *decoder, int index) {
+    if (decoder->cached_frame == index) return 0;
+
+#ifdef SIF_HAVE_ZSTD
+    const SeekEntry *frame = &decoder->frames[index];
+    if (!decoder->frame_data) {
+        decoder->frame_data = sif_mem_alloc(decoder->alloc, decoder->frame_capacity > 0 ? decoder->frame_capacity : 1);
+        if (!decoder->frame_data) return -1;
+    }
+
+    unsigned char *compressed = sif_mem_alloc(decoder->alloc, frame->compressed_size);
+    if (!compressed) return -1;
+
+    int result = -1;
+    if (pread_full(decoder->fd, compressed, frame->compressed_size, frame->compressed_offset) ==
+        (ssize_t)frame->compressed_size) {
+        size_t size = ZSTD_decompressDCtx(decoder->dctx, decoder->frame_data, decoder->frame_capacity,
+                                          compressed, frame->compressed_size);
+        if (!ZSTD_isError(size) && size == frame->size) {
+            decoder->cached_frame = index;
+            result = 0;
+        }
+    }
+    sif_mem_free(decoder->alloc, compressed);
+    if (result != 0) errno = EIO;
+    return result;
+#else
+    (void)index;
+    errno = ENOTSUP;
+    return -1;
+#endif
+}
+
+static int64_t seekable_pread(struct SifDecoder *decoder, unsigned char *dst, size_t count, int64_t offset) {
+    // last frame starting at or before offset
+    int low = 0, high = decoder->frame_count - 1;
+    while (low < high) {
+        int mid = (low + high + 1) / 2;
+        if (decoder->frames[mid].offset <= offset) low = mid;
+        else high = mid - 1;
+    }
+
+    size_t done = 0;
+    for (int index = low; index < decoder->frame_count && done < count; index++) {
+        const SeekEntry *frame = &decoder->frames[index];
+        int64_t position = offset + (int64_t)done;
+        if (position >= frame->offset + frame->size) continue;
+        if (decode_frame(decoder, index) != 0) return -1;
+
+        size_t skip = (size_t)(position - frame->offset);
+        size_t take = frame->size - skip;
+        if (take > count - done) take = count - done;
+        memcpy(dst + done, decoder->frame_data + skip, take);
+        done += take;
+    }
+    return (int64_t)done;
+}
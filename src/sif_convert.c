@@ -0,0 +1,377 @@
+/*
+ * csif - Andor SIF Parser in C
+ * Copyright (C) 2025 mithgil
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "sif_convert.h"
+#include "sif_utils.h"
+#include "sif_stats.h"
+#include <math.h>
+#include <pthread.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define SIF_CONVERT_X86 1
+#endif
+
+// float32 staging per read; with the converted output it stays in L2
+#define SIF_CONVERT_CHUNK_BYTES (64 << 10)
+
+const SifConvertOptions SIF_DEFAULT_CONVERT_OPTIONS = {
+    .dtype = SIF_DTYPE_FLOAT64,
+    .scale = 1.0,
+    .offset = 0.0,
+    .enable_byte_swap = 0
+};
+
+typedef struct {
+    float scale_f;                // uint16 works in float, like the pixels
+    float offset_f;
+    double scale;                 // uint32 needs the extra precision
+    double offset;
+} ConvertParams;
+
+typedef void (*ConvertKernel)(const float *src, void *dst, size_t count, const ConvertParams *params);
+
+typedef struct {
+    ConvertKernel kernels[SIF_DTYPE_UINT32 + 1];
+    const char *name;
+} ConvertTable;
+
+// scalar reference kernels
+
+static void to_f32_scalar(const float *src, void *dst, size_t count, const ConvertParams *params) {
+    (void)params;
+    if ((const void *)src != dst) {
+        memcpy(dst, src, count * sizeof(float));
+    }
+}
+
+static void to_f64_scalar(const float *src, void *dst, size_t count, const ConvertParams *params) {
+    (void)params;
+    double *out = dst;
+    for (size_t i = 0; i < count; i++) {
+        out[i] = (double)src[i];
+    }
+}
+
+static uint16_t float_to_half(float value) {
+    uint32_t x;
+    memcpy(&x, &value, sizeof(x));
+
+    uint16_t sign = (uint16_t)((x >> 16) & 0x8000);
+    uint32_t exponent = (x >> 23) & 0xFF;
+    uint32_t mantissa = x & 0x7FFFFF;
+
+    if (exponent == 0xFF) {  // inf, or a quiet NaN keeping the top payload bits
+        return sign | 0x7C00 | (mantissa ? 0x200 | (mantissa >> 13) : 0);
+    }
+
+    int e = (int)exponent - 127 + 15;
+    if (e >= 31) {
+        return sign | 0x7C00;
+    }
+
+    uint32_t half;
+    uint32_t rest;
+    uint32_t middle;
+    if (e <= 0) {  // subnormal half (or zero)
+        if (e < -10) {
+            return sign;
+        }
+        mantissa |= 0x800000;
+        int shift = 14 - e;
+        half = mantissa >> shift;
+        rest = mantissa & ((1u << shift) - 1);
+        middle = 1u << (shift - 1);
+    } else {
+        half = ((uint32_t)e << 10) | (mantissa >> 13);
+        rest = mantissa & 0x1FFF;
+        middle = 0x1000;
+    }
+
+    // round to nearest even; a carry into the exponent is still correct
+    if (rest > middle || (rest == middle && (half & 1))) {
+        half++;
+    }
+    return sign | (uint16_t)half;
+}
+
+static void to_f16_scalar(const float *src, void *dst, size_t count, const ConvertParams *params) {
+    (void)params;
+    uint16_t *out = dst;
+    for (size_t i = 0; i < count; i++) {
+        out[i] = float_to_half(src[i]);
+    }
+}
+
+static void to_bf16_scalar(const float *src, void *dst, size_t count, const ConvertParams *params) {
+    (void)params;
+    uint16_t *out = dst;
+    for (size_t i = 0; i < count; i++) {
+        uint32_t x;
+        memcpy(&x, &src[i], sizeof(x));
+        if ((x & 0x7FFFFFFF) > 0x7F800000) {
+            out[i] = (uint16_t)((x >> 16) | 0x40);
+            continue;
+        }
+        x += 0x7FFF + ((x >> 16) & 1);
+        out[i] = (uint16_t)(x >> 16);
+    }
+}
+
+static void to_u16_scalar(const float *src, void *dst, size_t count, const ConvertParams *params) {
+    uint16_t *out = dst;
+    for (size_t i = 0; i < count; i++) {
+        float v = src[i] * params->scale_f + params->offset_f;
+        if (!(v > 0.0f)) v = 0.0f;  // negative and NaN
+        if (v > 65535.0f) v = 65535.0f;
+        out[i] = (uint16_t)lrintf(v);
+    }
+}
+
+static void to_u32_scalar(const float *src, void *dst, size_t count, const ConvertParams *params) {
+    uint32_t *out = dst;
+    for (size_t i = 0; i < count; i++) {
+        double v = (double)src[i] * params->scale + params->offset;
+        if (!(v > 0.0)) v = 0.0;
+        if (v > 4294967295.0) v = 4294967295.0;
+        out[i] = (uint32_t)llrint(v);
+    }
+}
+
+static const ConvertTable scalar_table = {
+    { to_f32_scalar, to_f64_scalar, to_f16_scalar, to_bf16_scalar, to_u16_scalar, to_u32_scalar },
+    "scalar"
+};
+
+#if SIF_CONVERT_X86
+// AVX2 (+F16C) kernels, 8 pixels per step; tails go to the scalar kernels,
+// which round the same way, so output does not depend on the split
+
+#define SIF_AVX2 __attribute__((target("avx2,f16c")))
+
+SIF_AVX2
+static void to_f64_avx2(const float *src, void *dst, size_t count, const ConvertParams *params) {
+    double *out = dst;
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 v = _mm256_loadu_ps(src + i);
+        _mm256_storeu_pd(out + i, _mm256_cvtps_pd(_mm256_castps256_ps128(v)));
+        _mm256_storeu_pd(out + i + 4, _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)));
+    }
+    to_f64_scalar(src + i, out + i, count - i, params);
+}
+
+SIF_AVX2
+static void to_f16_avx2(const float *src, void *dst, size_t count, const ConvertParams *params) {
+    uint16_t *out = dst;
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        _mm_storeu_si128((__m128i *)(out + i), h);
+    }
+    to_f16_scalar(src + i, out + i, count - i, params);
+}
+
+// eight 32-bit lanes holding 0..65535 down to eight uint16 values
+SIF_AVX2
+static inline __m128i narrow_u16(__m256i v) {
+    __m256i packed = _mm256_packus_epi32(v, v);  // packs within each 128-bit lane
+    return _mm256_castsi256_si128(_mm256_permute4x64_epi64(packed, 0x08));
+}
+
+SIF_AVX2
+static void to_bf16_avx2(const float *src, void *dst, size_t count, const ConvertParams *params) {
+    uint16_t *out = dst;
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i bias = _mm256_set1_epi32(0x7FFF);
+    const __m256i quiet = _mm256_set1_epi32(0x40);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 v = _mm256_loadu_ps(src + i);
+        __m256i bits = _mm256_castps_si256(v);
+        __m256i lsb = _mm256_and_si256(_mm256_srli_epi32(bits, 16), one);
+        __m256i rounded = _mm256_srli_epi32(_mm256_add_epi32(bits, _mm256_add_epi32(bias, lsb)), 16);
+        __m256i nan = _mm256_castps_si256(_mm256_cmp_ps(v, v, _CMP_UNORD_Q));
+        __m256i quiet_nan = _mm256_or_si256(_mm256_srli_epi32(bits, 16), quiet);
+        _mm_storeu_si128((__m128i *)(out + i), narrow_u16(_mm256_blendv_epi8(rounded, quiet_nan, nan)));
+    }
+    to_bf16_scalar(src + i, out + i, count - i, params);
+}
+
+SIF_AVX2
+static void to_u16_avx2(const float *src, void *dst, size_t count, const ConvertParams *params) {
+    uint16_t *out = dst;
+    const __m256 scale = _mm256_set1_ps(params->scale_f);
+    const __m256 offset = _mm256_set1_ps(params->offset_f);
+    const __m256 high = _mm256_set1_ps(65535.0f);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 v = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(src + i), scale), offset);
+        v = _mm256_min_ps(_mm256_max_ps(v, _mm256_setzero_ps()), high);  // max() maps NaN to 0
+        _mm_storeu_si128((__m128i *)(out + i), narrow_u16(_mm256_cvtps_epi32(v)));
+    }
+    to_u16_scalar(src + i, out + i, count - i, params);
+}
+
+SIF_AVX2
+static void to_u32_avx2(const float *src, void *dst, size_t count, const ConvertParams *params) {
+    uint32_t *out = dst;
+    const __m256d scale = _mm256_set1_pd(params->scale);
+    const __m256d offset = _mm256_set1_pd(params->offset);
+    const __m256d high = _mm256_set1_pd(4294967295.0);
+    const __m256d half_range = _mm256_set1_pd(2147483648.0);
+    const __m128i sign = _mm_set1_epi32((int)0x80000000u);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256d v = _mm256_add_pd(_mm256_mul_pd(_mm256_cvtps_pd(_mm_loadu_ps(src + i)), scale), offset);
+        v = _mm256_min_pd(_mm256_max_pd(v, _mm256_setzero_pd()), high);
+        v = _mm256_round_pd(v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        // no unsigned conversion: shift the (now exact) integer into int32
+        // range and flip the sign bit back
+        __m128i r = _mm256_cvtpd_epi32(_mm256_sub_pd(v, half_range));
+        _mm_storeu_si128((__m128i *)(out + i), _mm_xor_si128(r, sign));
+    }
+    to_u32_scalar(src + i, out + i, count - i, params);
+}
+
+static const ConvertTable avx2_table = {
+    { to_f32_scalar, to_f64_avx2, to_f16_avx2, to_bf16_avx2, to_u16_avx2, to_u32_avx2 },
+    "avx2"
+};
+#endif
+
+static const ConvertTable *convert_table;
+
+static void pick_convert_table(void) {
+    convert_table = &scalar_table;
+#if SIF_CONVERT_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("f16c")) {
+        convert_table = &avx2_table;
+    }
+#endif
+}
+
+static pthread_once_t convert_once = PTHREAD_ONCE_INIT;
+
+static ConvertParams make_params(const SifConvertOptions *options) {
+    ConvertParams params;
+    params.scale = options->scale;
+    params.offset = options->offset;
+    params.scale_f = (float)options->scale;
+    params.offset_f = (float)options->offset;
+    return params;
+}
+
+size_t sif_dtype_size(SifDtype dtype) {
+    switch (dtype) {
+        case SIF_DTYPE_FLOAT32:  return 4;
+        case SIF_DTYPE_FLOAT64:  return 8;
+        case SIF_DTYPE_FLOAT16:  return 2;
+        case SIF_DTYPE_BFLOAT16: return 2;
+        case SIF_DTYPE_UINT16:   return 2;
+        case SIF_DTYPE_UINT32:   return 4;
+    }
+    return 0;
+}
+
+const char *sif_dtype_name(SifDtype dtype) {
+    switch (dtype) {
+        case SIF_DTYPE_FLOAT32:  return "float32";
+        case SIF_DTYPE_FLOAT64:  return "float64";
+        case SIF_DTYPE_FLOAT16:  return "float16";
+        case SIF_DTYPE_BFLOAT16: return "bfloat16";
+        case SIF_DTYPE_UINT16:   return "uint16";
+        case SIF_DTYPE_UINT32:   return "uint32";
+    }
+    return "unknown";
+}
+
+int sif_convert_pixels(const float *src, void *dst, size_t count, SifConvertOptions options) {
+    if (!src || !dst || sif_dtype_size(options.dtype) == 0) {
+        return -1;
+    }
+
+    pthread_once(&convert_once, pick_convert_table);
+    ConvertParams params = make_params(&options);
+    convert_table->kernels[options.dtype](src, dst, count, &params);
+    return 0;
+}
+
+int sif_read_frames_as(const SifFile *sif_file, int start_frame, int frame_count,
+                       void *out, SifConvertOptions options) {
+    if (!sif_file || !out || frame_count <= 0) {
+        return -1;
+    }
+
+    size_t element_size = sif_dtype_size(options.dtype);
+    if (element_size == 0) {
+        return -1;
+    }
+
+    // float32 is the file's own format: read straight into out
+    if (options.dtype == SIF_DTYPE_FLOAT32) {
+        return sif_read_frames(sif_file, start_frame, frame_count, (float *)out, options.enable_byte_swap);
+    }
+
+    if (start_frame < 0 || start_frame + frame_count > sif_file->frame_count) {
+        return -1;
+    }
+
+    size_t total = (size_t)frame_count * sif_file->info.pixels_per_frame;
+    size_t chunk = SIF_CONVERT_CHUNK_BYTES / sizeof(float);
+    if (chunk > total) {
+        chunk = total;
+    }
+
+    float *staging = sif_mem_alloc(sif_file->info.alloc, chunk * sizeof(float));
+    if (!staging) {
+        return -1;
+    }
+    SIF_STATS_ALLOC(sif_file->stats, chunk * sizeof(float));
+
+    pthread_once(&convert_once, pick_convert_table);
+    ConvertKernel kernel = convert_table->kernels[options.dtype];
+    ConvertParams params = make_params(&options);
+
+    int64_t offset = sif_frame_offset(sif_file, start_frame);
+    unsigned char *dst = out;
+    size_t done = 0;
+
+    while (done < total) {
+        size_t want = total - done < chunk ? total - done : chunk;
+        int64_t got = sif_read_pixels(sif_file, offset + (int64_t)(done * sizeof(float)), staging, want,
+                                      options.enable_byte_swap);
+        if (got != (int64_t)want) {
+            const SifLogSink *previous_log = sif_log_enter(&sif_file->info);
+            PRINT_SILENT("⚠️ Frames %d-%d: Only read %zu/%zu pixels\n", start_frame,
+                         start_frame + frame_count - 1, done + (got > 0 ? (size_t)got : 0), total);
+            sif_log_leave(previous_log);
+            sif_mem_free(sif_file->info.alloc, staging);
+            return -1;
+        }
+
+        SIF_STATS_START(convert_start);
+        kernel(staging, dst + done * element_size, want, &params);
+        SIF_STATS_PHASE(sif_file->stats, SIF_PHASE_CONVERT, convert_start, want * element_size);
+        done += want;
+    }
+
+    sif_mem_free(sif_file->info.alloc, staging);
+    return 0;
+}
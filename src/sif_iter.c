@@ -0,0 +1,233 @@
+/*
+ * csif - Andor SIF Parser in C
+ * Copyright (C) 2025 mithgil
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#define _POSIX_C_SOURCE 200809L  // pread
+
+#include "sif_iter.h"
+#include "sif_utils.h"
+#include "sif_stats.h"
+#include <errno.h>
+#include <pthread.h>
+
+#define SIF_ITER_BUFFERS 2
+
+typedef struct {
+    float *data;
+    int first_frame;
+    int frame_count;
+    int full;                     // filled by the reader, not yet handed back
+    int error;                    // errno of a failed read
+} IterBuffer;
+
+struct SifFrameIter {
+    SifFile *sif_file;
+    int batch_frames;
+    int enable_byte_swap;
+    size_t frame_size;            // all tracks
+
+    IterBuffer buffers[SIF_ITER_BUFFERS];
+    int consumer_buffer;          // buffer handed out last, -1 before the first batch
+    int next_buffer;              // buffer the consumer takes next
+    int finished;                 // last batch handed back
+
+    pthread_t reader;
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    int stop;
+};
+
+static int fill_buffer(SifFrameIter *iter, IterBuffer *buffer, int first_frame);
+static void *iter_reader(void *arg);
+
+static int fill_buffer(SifFrameIter *iter, IterBuffer *buffer, int first_frame) {
+    SifFile *sif_file = iter->sif_file;
+    int count = sif_file->frame_count - first_frame;
+    if (count > iter->batch_frames) count = iter->batch_frames;
+
+    size_t batch_bytes = (size_t)count * iter->frame_size * sizeof(float);
+
+    // frames (all tracks) are back to back: one read for the whole batch
+    SIF_STATS_START(read_start);
+    int64_t got = sif_read_at(sif_file, buffer->data, batch_bytes, sif_frame_offset(sif_file, first_frame));
+
+    if (got < 0) {
+        buffer->error = errno;
+        return -1;
+    }
+    SIF_STATS_READ(sif_file->stats, (uint64_t)got, 1);
+    SIF_STATS_PHASE(sif_file->stats, SIF_PHASE_FRAME_READ, read_start, (uint64_t)got);
+
+    if ((size_t)got < batch_bytes) {
+        PRINT_SILENT("⚠️ Frames %d-%d: Only read %zu/%zu pixels\n", first_frame, first_frame + count - 1,
+               (size_t)got / sizeof(float), batch_bytes / sizeof(float));
+        memset((unsigned char *)buffer->data + got, 0, batch_bytes - (size_t)got);
+    }
+
+    if (iter->enable_byte_swap) {
+        SIF_STATS_START(swap_start);
+        swap_float_array_endian(buffer->data, (size_t)count * iter->frame_size);
+        SIF_STATS_PHASE(sif_file->stats, SIF_PHASE_BYTE_SWAP, swap_start, batch_bytes);
+    }
+
+    buffer->first_frame = first_frame;
+    buffer->frame_count = count;
+    buffer->error = 0;
+    return 0;
+}
+
+// background reader: fills the buffers in turn, waiting for each one to
+// be handed back by the consumer before reusing it
+static void *iter_reader(void *arg) {
+    SifFrameIter *iter = (SifFrameIter *)arg;
+    int frame = 0;
+    int index = 0;
+
+    // this thread logs on behalf of the iterated handle
+    sif_log_enter(&iter->sif_file->info);
+
+    while (frame < iter->sif_file->frame_count) {
+        IterBuffer *buffer = &iter->buffers[index];
+
+        pthread_mutex_lock(&iter->lock);
+        while (buffer->full && !iter->stop) {
+            pthread_cond_wait(&iter->changed, &iter->lock);
+        }
+        int stop = iter->stop;
+        pthread_mutex_unlock(&iter->lock);
+        if (stop) break;
+
+        int rc = fill_buffer(iter, buffer, frame);
+
+        pthread_mutex_lock(&iter->lock);
+        buffer->full = 1;
+        pthread_cond_broadcast(&iter->changed);
+        pthread_mutex_unlock(&iter->lock);
+
+        if (rc != 0) break;
+        frame += buffer->frame_count;
+        index = (index + 1) % SIF_ITER_BUFFERS;
+    }
+
+    return NULL;
+}
+
+SifFrameIter *sif_frame_iter_open(SifFile *sif_file, int batch_frames, int enable_byte_swap) {
+    if (!sif_file || !sif_file->file_ptr || sif_file->frame_count == 0 || sif_file->info.pixels_per_frame == 0) {
+        return NULL;
+    }
+
+    if (batch_frames < 1) batch_frames = 1;
+    if (batch_frames > sif_file->frame_count) batch_frames = sif_file->frame_count;
+
+    SifFrameIter *iter = sif_mem_calloc(sif_file->info.alloc, 1, sizeof(SifFrameIter));
+    if (!iter) return NULL;
+
+    iter->sif_file = sif_file;
+    iter->batch_frames = batch_frames;
+    iter->enable_byte_swap = enable_byte_swap;
+    iter->frame_size = (size_t)sif_file->info.pixels_per_frame;
+    iter->consumer_buffer = -1;
+
+    for (int i = 0; i < SIF_ITER_BUFFERS; i++) {
+        iter->buffers[i].data = sif_mem_alloc(sif_file->info.alloc, (size_t)batch_frames * iter->frame_size * sizeof(float));
+        if (!iter->buffers[i].data) {
+            PRINT_SILENT("❌ Failed to allocate memory\n");
+            for (int j = 0; j < i; j++) sif_mem_free(sif_file->info.alloc, iter->buffers[j].data);
+            sif_mem_free(sif_file->info.alloc, iter);
+            return NULL;
+        }
+        SIF_STATS_ALLOC(sif_file->stats, (size_t)batch_frames * iter->frame_size * sizeof(float));
+    }
+
+    pthread_mutex_init(&iter->lock, NULL);
+    pthread_cond_init(&iter->changed, NULL);
+
+    if (pthread_create(&iter->reader, NULL, iter_reader, iter) != 0) {
+        PRINT_SILENT("❌ Failed to start reader thread\n");
+        pthread_mutex_destroy(&iter->lock);
+        pthread_cond_destroy(&iter->changed);
+        for (int i = 0; i < SIF_ITER_BUFFERS; i++) sif_mem_free(sif_file->info.alloc, iter->buffers[i].data);
+        sif_mem_free(sif_file->info.alloc, iter);
+        return NULL;
+    }
+
+    PRINT_VERBOSE("✓ Frame iterator: %d frame(s) per batch, %d buffers\n", batch_frames, SIF_ITER_BUFFERS);
+    return iter;
+}
+
+int sif_frame_iter_next(SifFrameIter *iter, const float **frames, int *first_frame) {
+    if (!iter || !frames) return -1;
+
+    if (iter->finished) {
+        *frames = NULL;
+        return 0;
+    }
+
+    pthread_mutex_lock(&iter->lock);
+
+    // the previous batch is done with, let the reader refill it
+    if (iter->consumer_buffer >= 0) {
+        IterBuffer *previous = &iter->buffers[iter->consumer_buffer];
+        iter->finished = previous->first_frame + previous->frame_count >= iter->sif_file->frame_count;
+        previous->full = 0;
+        iter->consumer_buffer = -1;
+        pthread_cond_broadcast(&iter->changed);
+
+        if (iter->finished) {
+            pthread_mutex_unlock(&iter->lock);
+            *frames = NULL;
+            return 0;
+        }
+    }
+
+    IterBuffer *buffer = &iter->buffers[iter->next_buffer];
+    while (!buffer->full) {
+        pthread_cond_wait(&iter->changed, &iter->lock);
+    }
+    pthread_mutex_unlock(&iter->lock);
+
+    if (buffer->error != 0) {
+        PRINT_SILENT("❌ Read error while iterating frames: %s\n", strerror(buffer->error));
+        *frames = NULL;
+        return -1;
+    }
+
+    iter->consumer_buffer = iter->next_buffer;
+    iter->next_buffer = (iter->next_buffer + 1) % SIF_ITER_BUFFERS;
+
+    *frames = buffer->data;
+    if (first_frame) *first_frame = buffer->first_frame;
+    return buffer->frame_count;
+}
+
+void sif_frame_iter_close(SifFrameIter *iter) {
+    if (!iter) return;
+
+    pthread_mutex_lock(&iter->lock);
+    iter->stop = 1;
+    pthread_cond_broadcast(&iter->changed);
+    pthread_mutex_unlock(&iter->lock);
+
+    pthread_join(iter->reader, NULL);
+
+    pthread_mutex_destroy(&iter->lock);
+    pthread_cond_destroy(&iter->changed);
+    struct SifAllocState *alloc = iter->sif_file->info.alloc;
+    for (int i = 0; i < SIF_ITER_BUFFERS; i++) sif_mem_free(alloc, iter->buffers[i].data);
+    sif_mem_free(alloc, iter);
+}
@@ -17,6 +17,7 @@
  */
  
 #include "sif_json.h"
+#include "sif_stats.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -64,11 +65,12 @@ static char* json_escape_string(const char *input);
 static void json_buffer_init(JsonBuffer *buffer);
 static void json_buffer_append(JsonBuffer *buffer, const char *format, ...);
 static void json_buffer_free(JsonBuffer *buffer);
+static char* file_to_json(SifFile *sif_file, JsonOutputOptions options);
 
 
 static void json_buffer_init(JsonBuffer *buffer) {
     buffer->capacity = 4096;
-    buffer->data = malloc(buffer->capacity);
+    buffer->data = sif_mem_alloc(NULL, buffer->capacity);
     buffer->length = 0;
     if (buffer->data) {
         buffer->data[0] = '\0';
@@ -90,7 +92,7 @@ static void json_buffer_append(JsonBuffer *buffer, const char *format, ...) {
         while (new_length > buffer->capacity) {
             buffer->capacity *= 2;
         }
-        char *new_data = realloc(buffer->data, buffer->capacity);
+        char *new_data = sif_mem_realloc(NULL, buffer->data, buffer->capacity);
         if (!new_data) return;
         buffer->data = new_data;
     }
@@ -101,7 +103,7 @@ static void json_buffer_append(JsonBuffer *buffer, const char *format, ...) {
 
 static void json_buffer_free(JsonBuffer *buffer) {
     if (buffer->data) {
-        free(buffer->data);
+        sif_mem_free(NULL, buffer->data);
         buffer->data = NULL;
     }
     buffer->length = 0;
@@ -122,7 +124,7 @@ static char* json_escape_string(const char *input) {
         }
     }
     
-    char *escaped = malloc(escaped_len);
+    char *escaped = sif_mem_alloc(NULL, escaped_len);
     if (!escaped) return NULL;
     
     size_t j = 0;
@@ -159,29 +161,36 @@ static char* json_escape_string(const char *input) {
 
 // main json output
 char* sif_file_to_json(SifFile *sif_file, JsonOutputOptions options) {
-    printf("=== ENTERING sif_file_to_json ===\n");
+    SIF_STATS_START(json_start);
+    const SifLogSink *previous_log = sif_log_enter(sif_file ? &sif_file->info : NULL);
+    char *json = file_to_json(sif_file, options);
+    sif_log_leave(previous_log);
+    if (sif_file) {
+        SIF_STATS_PHASE(sif_file->stats, SIF_PHASE_JSON, json_start, 0);
+    }
+    return json;
+}
+
+static char* file_to_json(SifFile *sif_file, JsonOutputOptions options) {
+    PRINT_VERBOSE("=== ENTERING sif_file_to_json ===\n");
     
     if (!sif_file) {
-        printf("❌ sif_file is NULL\n");
+        PRINT_SILENT("❌ sif_file is NULL\n");
         return NULL;
     }
     
-    printf("  sif_file pointer: %p\n", sif_file);
-    printf("  data_loaded: %d\n", sif_file->data_loaded);
-    printf("  frame_data: %p\n", sif_file->frame_data);
-    printf("  frame_count: %d\n", sif_file->frame_count);
-    printf("  tiles: %p\n", sif_file->tiles);
-    
-    if (sif_file->tiles) {
-        printf("  tile[0]: width=%d, height=%d\n", 
-               sif_file->tiles[0].width, sif_file->tiles[0].height);
-    }
+    PRINT_DEBUG("  sif_file pointer: %p\n", sif_file);
+    PRINT_DEBUG("  data_loaded: %d\n", sif_file->data_loaded);
+    PRINT_DEBUG("  frame_data: %p\n", sif_file->frame_data);
+    PRINT_DEBUG("  frame_count: %d\n", sif_file->frame_count);
+    PRINT_DEBUG("  image: width=%d, height=%d\n", 
+           sif_file->info.image_width, sif_file->info.image_height);
     
     JsonBuffer buffer;
-    printf("→ Initializing JSON buffer...\n");
+    PRINT_VERBOSE("→ Initializing JSON buffer...\n");
     json_buffer_init(&buffer);
     
-    printf("→ Starting JSON generation...\n");
+    PRINT_VERBOSE("→ Starting JSON generation...\n");
     
     //Begin JSON object
     json_buffer_append(&buffer, "{");
@@ -192,7 +201,7 @@ char* sif_file_to_json(SifFile *sif_file, JsonOutputOptions options) {
     
     // metadata
     if (options.include_metadata) {
-        printf("→ Generating metadata...\n");
+        PRINT_VERBOSE("→ Generating metadata...\n");
 
         json_buffer_append(&buffer, "\"metadata\": {");
         if (options.pretty_print) json_buffer_append(&buffer, "\n    ");
@@ -213,19 +222,19 @@ char* sif_file_to_json(SifFile *sif_file, JsonOutputOptions options) {
         // escape camera name
         char *escaped_camera = json_escape_string(sif_file->info.detector_type);
         json_buffer_append(&buffer, "\"cameraModel\": \"%s\",", escaped_camera ? escaped_camera : "");
-        if (escaped_camera) free(escaped_camera);
+        if (escaped_camera) sif_free(escaped_camera);
         if (options.pretty_print) json_buffer_append(&buffer, "\n    ");
         
         // escape the raw filename
         char *escaped_filename = json_escape_string(sif_file->info.original_filename);
         json_buffer_append(&buffer, "\"originalFilename\": \"%s\",", escaped_filename ? escaped_filename : "");
-        if (escaped_filename) free(escaped_filename);
+        if (escaped_filename) sif_free(escaped_filename);
         if (options.pretty_print) json_buffer_append(&buffer, "\n    ");
         
         // Escape datatype
         char *escaped_datatype = json_escape_string(sif_file->info.data_type);
         json_buffer_append(&buffer, "\"dataType\": \"%s\"", escaped_datatype ? escaped_datatype : "");
-        if (escaped_datatype) free(escaped_datatype);
+        if (escaped_datatype) sif_free(escaped_datatype);
         
         if (options.pretty_print) json_buffer_append(&buffer, "\n  ");
         json_buffer_append(&buffer, "},");
@@ -233,8 +242,11 @@ char* sif_file_to_json(SifFile *sif_file, JsonOutputOptions options) {
     }
 
     // calibration
+    if (options.include_calibration) {
+        sif_ensure_calibration(&sif_file->info);
+    }
     if (options.include_calibration && sif_file->info.calibration_coeff_count > 0) {
-        printf("→ Generating calibration...\n");
+        PRINT_VERBOSE("→ Generating calibration...\n");
         json_buffer_append(&buffer, "\"calibration\": {");
         if (options.pretty_print) json_buffer_append(&buffer, "\n    ");
         
@@ -251,7 +263,7 @@ char* sif_file_to_json(SifFile *sif_file, JsonOutputOptions options) {
         // escape frameAxis
         char *escaped_frameaxis = json_escape_string(sif_file->info.frame_axis);
         json_buffer_append(&buffer, "\"frameAxis\": \"%s\"", escaped_frameaxis ? escaped_frameaxis : "");
-        if (escaped_frameaxis) free(escaped_frameaxis);
+        if (escaped_frameaxis) sif_free(escaped_frameaxis);
         
         if (options.pretty_print) json_buffer_append(&buffer, "\n  ");
         json_buffer_append(&buffer, "},");
@@ -269,41 +281,41 @@ char* sif_file_to_json(SifFile *sif_file, JsonOutputOptions options) {
     if (options.pretty_print) json_buffer_append(&buffer, "\n  ");
     
     // raw data
-    printf("→ Generating data array...\n");
-    printf("  include_raw_data: %d\n", options.include_raw_data);
-    printf("  frame_data exists: %d\n", sif_file->frame_data != NULL);
-    printf("  data_loaded: %d\n", sif_file->data_loaded);
+    PRINT_VERBOSE("→ Generating data array...\n");
+    PRINT_DEBUG("  include_raw_data: %d\n", options.include_raw_data);
+    PRINT_DEBUG("  frame_data exists: %d\n", sif_file->frame_data != NULL);
+    PRINT_DEBUG("  data_loaded: %d\n", sif_file->data_loaded);
 
     if (options.include_raw_data && sif_file->frame_data && sif_file->data_loaded) {
-        printf("✓ Outputting real data\n");
+        PRINT_VERBOSE("✓ Outputting real data\n");
         
-        int frame_size = sif_file->info.image_width * sif_file->info.image_height;
-        int total_frames = sif_file->info.number_of_frames;
-        int total_data_points = total_frames * frame_size;
+        size_t frame_size = sif_file->info.pixels_per_frame;
+        int total_frames = sif_file->loaded_frame_count;  // frames held in frame_data
+        size_t total_data_points = (size_t)total_frames * frame_size;
         
-        printf("  Frame size: %d x %d = %d pixels\n", 
-            sif_file->info.image_width, sif_file->info.image_height, frame_size);
-        printf("  Total frames: %d, Total data points: %d\n", total_frames, total_data_points);
+        PRINT_DEBUG("  Frame size: %zu pixels (%d track(s))\n", 
+            frame_size, sif_file->info.number_of_subimages);
+        PRINT_DEBUG("  Total frames: %d, Total data points: %zu\n", total_frames, total_data_points);
         
         float *frame0 = sif_file->frame_data; // the beginning position of the frist frame
-        printf("  Frame 0 pointer: %p\n", frame0);
+        PRINT_DEBUG("  Frame 0 pointer: %p\n", frame0);
         
         // display the first 10 values
-        printf("  First 10 values from frame_data:\n");
-        for (int i = 0; i < 10 && i < frame_size; i++) {
-            printf("    [%d] = %.1f\n", i, frame0[i]);
+        PRINT_DEBUG("  First 10 values from frame_data:\n");
+        for (size_t i = 0; i < 10 && i < frame_size; i++) {
+            PRINT_DEBUG("    [%zu] = %.1f\n", i, frame0[i]);
         }
         
         json_buffer_append(&buffer, "\"data\": [", 9);
         
         // output data
-        int output_points = total_data_points;
+        size_t output_points = total_data_points;
         
         for (int frame = 0; frame < total_frames; frame++) {
             // 計算當前幀的起始位置
-            float *current_frame = frame0 + (frame * frame_size);
+            float *current_frame = frame0 + ((size_t)frame * frame_size);
             
-            for (int i = 0; i < frame_size; i++) {
+            for (size_t i = 0; i < frame_size; i++) {
                 float value = current_frame[i];
                 
                 // use char to construct
@@ -316,7 +328,7 @@ char* sif_file_to_json(SifFile *sif_file, JsonOutputOptions options) {
                 json_buffer_append(&buffer, num_str, strlen(num_str));
                 
                 // 檢查是否是最後一個元素
-                int current_index = frame * frame_size + i;
+                size_t current_index = (size_t)frame * frame_size + i;
                 if (current_index < output_points - 1) {
                     json_buffer_append(&buffer, ", ", 2);
                 }
@@ -324,11 +336,11 @@ char* sif_file_to_json(SifFile *sif_file, JsonOutputOptions options) {
         }
         
         json_buffer_append(&buffer, "]", 1);
-        printf("✓ Output %d data points\n", output_points);
+        PRINT_VERBOSE("✓ Output %zu data points\n", output_points);
         
     } else {
-        printf("⚠️ Outputting empty data array\n");
-        printf("  Reason: include_raw_data=%d, frame_data=%p, data_loaded=%d\n",
+        PRINT_VERBOSE("⚠️ Outputting empty data array\n");
+        PRINT_DEBUG("  Reason: include_raw_data=%d, frame_data=%p, data_loaded=%d\n",
             options.include_raw_data, sif_file->frame_data, sif_file->data_loaded);
         json_buffer_append(&buffer, "\"data\": []", 10);
     }
@@ -338,9 +350,9 @@ char* sif_file_to_json(SifFile *sif_file, JsonOutputOptions options) {
     }
     json_buffer_append(&buffer, "}");
 
-    printf("✓ JSON generation completed\n");
-    printf("  Buffer size: %zu\n", buffer.length);
-    printf("=== EXITING sif_file_to_json ===\n");
+    PRINT_VERBOSE("✓ JSON generation completed\n");
+    PRINT_DEBUG("  Buffer size: %zu\n", buffer.length);
+    PRINT_VERBOSE("=== EXITING sif_file_to_json ===\n");
     
     return buffer.data;
 }
@@ -359,12 +371,12 @@ int sif_save_as_json(SifFile *sif_file, const char *filename, JsonOutputOptions
     
     FILE *fp = fopen(filename, "w");
     if (!fp) {
-        free(json);
+        sif_free(json);
         return 0;
     }
     
     fputs(json, fp);
     fclose(fp);
-    free(json);
+    sif_free(json);
     return 1;
 }
\ No newline at end of file
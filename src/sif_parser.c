@@ -16,12 +16,25 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
-#define _POSIX_C_SOURCE 200809L  // strdup
+#define _POSIX_C_SOURCE 200809L  // pread, strtok_r
+#define _GNU_SOURCE              // O_DIRECT
 
 #include "sif_parser.h"
 #include "sif_utils.h"
+#include "sif_prefetch.h"
+#include "sif_cache.h"
+#include "sif_stats.h"
+#include "sif_compress.h"
 #include <ctype.h>
+#include <stddef.h>
 #include <inttypes.h>
+#include <limits.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 SifVerboseLevel current_verbose_level = SIF_NORMAL;
 
@@ -29,26 +42,167 @@ void sif_set_verbose_level(SifVerboseLevel level) {
     current_verbose_level = level;
 }
 
+// sink of the handle the calling thread is working on, NULL: global level
+static _Thread_local const SifLogSink *active_log;
+
+const SifLogSink *sif_log_enter(const SifInfo *info) {
+    const SifLogSink *previous = active_log;
+    if (info && info->has_log) {
+        active_log = &info->log;
+    }
+    return previous;
+}
+
+void sif_log_leave(const SifLogSink *previous) {
+    active_log = previous;
+}
+
+SifVerboseLevel sif_log_level(void) {
+    return active_log ? active_log->level : current_verbose_level;
+}
+
+void sif_set_log_sink(SifFile *sif_file, const SifLogSink *log) {
+    if (!sif_file) return;
+
+    if (log) {
+        sif_file->info.log = *log;
+        sif_file->info.has_log = 1;
+    } else {
+        memset(&sif_file->info.log, 0, sizeof(SifLogSink));
+        sif_file->info.has_log = 0;
+    }
+}
+
 void sif_print(SifVerboseLevel min_level, const char* format, ...) {
-    if (current_verbose_level >= min_level) {
-        va_list args;
-        va_start(args, format);
+    const SifLogSink *log = active_log;
+    SifVerboseLevel level = log ? log->level : current_verbose_level;
+    if (level < min_level) return;
+
+    va_list args;
+    va_start(args, format);
+
+    if (!log || !log->callback) {
         vprintf(format, args);
         va_end(args);
+        return;
+    }
+
+    // format into a stack buffer, going to the heap only for long messages
+    char message[512];
+    va_list retry;
+    va_copy(retry, args);
+    int length = vsnprintf(message, sizeof(message), format, args);
+    va_end(args);
+
+    if (length >= (int)sizeof(message)) {
+        char *long_message = sif_mem_alloc(NULL, (size_t)length + 1);
+        if (long_message) {
+            vsnprintf(long_message, (size_t)length + 1, format, retry);
+            log->callback(min_level, long_message, log->user_data);
+            sif_mem_free(NULL, long_message);
+            va_end(retry);
+            return;
+        }
+    }
+    va_end(retry);
+
+    if (length >= 0) {
+        log->callback(min_level, message, log->user_data);
     }
 }
 
-static void swap_float_array_endian(float *data, int count);
 static void extract_text_part_robust(const char *input, char *output, int max_length);
 
-static int read_binary_string(FILE *fp, char *buffer, int max_length, int length);
-static int read_line_with_binary_check(FILE *fp, char *buffer, int max_length);
-static int read_line_directly(FILE *fp, char *buffer, int max_length);
-
-static void discard_line(FILE *fp);
-static void discard_bytes(FILE *fp, long count);
+// buffered header reader: the header is pulled in with large reads and
+// tokenized from memory instead of byte-wise stdio calls and back-seeks
+#define SIF_READER_CHUNK 65536
+#define SIF_PROBE_CHUNK 16384
+
+typedef struct {
+    FILE *fp;
+    unsigned char *data;
+    size_t length;                // valid bytes in data
+    size_t capacity;
+    size_t pos;                   // cursor into data
+    long base;                    // file offset of data[0]
+    int eof;                      // nothing more to read from fp
+    int borrowed;                 // data is the caller's buffer (sif_open_memory)
+    struct SifDecoder *decoder;   // compressed file: reads go through the decompressor
+    struct SifAllocState *alloc;  // the handle's allocator
+    struct SifStatsState *stats;  // I/O counters, NULL when not counting
+} SifReader;
+
+static int reader_init(SifReader *r, FILE *fp, size_t capacity, struct SifAllocState *alloc);
+static void reader_init_memory(SifReader *r, const void *buffer, size_t length);
+static int reader_init_file(SifReader *r, SifFile *sif_file, FILE *fp, size_t capacity);
+static void reader_free(SifReader *r);
+static int reader_fill(SifReader *r, size_t min_bytes);
+static long reader_tell(const SifReader *r);
+static void reader_seek(SifReader *r, long offset);
+static int reader_getc(SifReader *r);
+static void reader_unget(SifReader *r);
+static size_t reader_read(SifReader *r, void *dst, size_t count);
+static char *reader_gets(SifReader *r, char *buffer, int size);
+static int reader_read_until(SifReader *r, char *buffer, int max_length, char terminator);
+static int reader_read_int(SifReader *r);
+static double reader_read_float(SifReader *r);
+static void reader_skip_spaces(SifReader *r);
+
+static int read_binary_string(SifReader *r, char *buffer, int max_length, int length);
+static int read_line_with_binary_check(SifReader *r, char *buffer, int max_length);
+static int read_line_directly(SifReader *r, char *buffer, int max_length);
+
+static void discard_line(SifReader *r);
+static void discard_bytes(SifReader *r, long count);
+static void discard_lines(SifReader *r, int count);
+static size_t parse_timestamp_lines(const unsigned char *text, size_t length, int64_t *timestamps,
+                                    int count, int *parsed);
+static int read_timestamps(SifReader *r, int64_t *timestamps, int count);
+
+// header_only: skip the user text, subimage table and timestamps (sif_probe);
+// lazy_timestamps: only note where the timestamp block is (sif_get_timestamps)
+static int parse_header(SifReader *r, SifFile *sif_file, int header_only, int lazy_timestamps);
 
 static void cleanup_sif_info(SifInfo *info);
+static void init_sif_info(SifInfo *info);
+static void release_file(SifFile *sif_file);
+static void *take_buffer(SifFile *sif_file, SifSpareBuffer *spare, size_t bytes);
+static void release_spare(SifFile *sif_file, SifSpareBuffer *spare);
+
+// loader bodies; the public sif_load_* wrappers route their log output
+// to the handle's sink
+static int load_all_frames(SifFile *sif_file, int enable_byte_swap);
+static int load_single_frame(SifFile *sif_file, int frame_index);
+static int load_frame_range(SifFile *sif_file, int start_frame, int end_frame);
+static int load_all_frames_parallel(SifFile *sif_file, int enable_byte_swap, int num_threads);
+static int load_all_frames_direct(SifFile *sif_file, int enable_byte_swap);
+
+static int map_frame_data(SifFile *sif_file);
+static ssize_t read_pixels(const SifFile *sif_file, int64_t offset, float *dst, size_t pixel_count,
+                           int enable_byte_swap);
+
+// parallel loading: each worker fills its own slice of frame_data with
+// positional reads, so no FILE* cursor is shared between threads
+#define SIF_MAX_LOAD_THREADS 64
+#define SIF_LOAD_BLOCK_BYTES (4 << 20)
+#define SIF_SWAP_CHUNK_BYTES (256 << 10)  // read-then-swap unit, sized to stay in L2
+
+typedef struct {
+    SifFile *sif_file;
+    int start_frame;
+    int end_frame;
+    int enable_byte_swap;
+    int error;                    // errno of a failed read, 0 on success
+    size_t missing_pixels;        // pixels not available (file too short)
+} FrameLoadTask;
+
+static void *frame_load_worker(void *arg);
+
+// cache-bypassing loading: O_DIRECT reads must start, end and land on
+// block boundaries, so frames are over-read and trimmed out of a bounce buffer
+#define SIF_DIRECT_ALIGN 4096
+#define SIF_DIRECT_BLOCK_BYTES (8 << 20)
+#define SIF_SAMPLE_ADVISE_AHEAD 16  // sampled frames announced to the kernel ahead of the read
 
 static void extract_text_part_robust(const char *input, char *output, int max_length) {
     if (!input || !output) return;
@@ -95,16 +249,207 @@ static void extract_text_part_robust(const char *input, char *output, int max_le
     }
 }
 
+static int reader_init(SifReader *r, FILE *fp, size_t capacity, struct SifAllocState *alloc) {
+    memset(r, 0, sizeof(SifReader));
+    r->fp = fp;
+    r->alloc = alloc;
+    r->base = ftell(fp);
+    if (r->base < 0) r->base = 0;
+
+    r->capacity = capacity;
+    r->data = sif_mem_alloc(r->alloc, r->capacity);
+    if (!r->data) return -1;
+
+    reader_fill(r, 1);
+    return 0;
+}
+
+// a compressed file is read through its decompressor: offsets are positions
+// in the decompressed file and the FILE* is not touched
+static int reader_init_decoder(SifReader *r, struct SifDecoder *decoder, size_t capacity,
+                               struct SifAllocState *alloc) {
+    memset(r, 0, sizeof(SifReader));
+    r->decoder = decoder;
+    r->alloc = alloc;
+
+    r->capacity = capacity;
+    r->data = sif_mem_alloc(r->alloc, r->capacity);
+    if (!r->data) return -1;
+
+    reader_fill(r, 1);
+    return 0;
+}
+
+// set up the header reader for fp, with a decompressor when the file starts
+// with a gzip or zstd magic number
+static int reader_init_file(SifReader *r, SifFile *sif_file, FILE *fp, size_t capacity) {
+    unsigned char head[4];
+    long start = ftell(fp);
+    ssize_t got = pread_full(fileno(fp), head, sizeof(head), start > 0 ? start : 0);
+    SifCompression compression = sif_detect_compression(head, got > 0 ? (size_t)got : 0);
+
+    if (compression != SIF_COMPRESSION_NONE) {
+        if (!sif_compression_supported(compression)) {
+            fprintf(stderr, "Error: %s-compressed file, but this build has no %s support\n",
+                    sif_compression_name(compression), sif_compression_name(compression));
+            return -1;
+        }
+        sif_file->decoder = sif_decoder_open(fp, compression, sif_file->info.alloc);
+        if (!sif_file->decoder) {
+            fprintf(stderr, "Error: Cannot set up the %s decompressor\n", sif_compression_name(compression));
+            return -1;
+        }
+        PRINT_VERBOSE("✓ Reading %s-compressed file\n", sif_compression_name(sif_decoder_compression(sif_file->decoder)));
+    }
+
+    int result = sif_file->decoder
+        ? reader_init_decoder(r, sif_file->decoder, capacity, sif_file->info.alloc)
+        : reader_init(r, fp, capacity, sif_file->info.alloc);
+    if (result != 0) {
+        fprintf(stderr, "Error: Cannot allocate header buffer\n");
+    }
+    return result;
+}
+
+// the whole file is already in memory: the buffer is the window, never
+// refilled or written to
+static void reader_init_memory(SifReader *r, const void *buffer, size_t length) {
+    memset(r, 0, sizeof(SifReader));
+    r->data = (unsigned char *)buffer;
+    r->length = r->capacity = length;
+    r->eof = 1;
+    r->borrowed = 1;
+}
+
+static void reader_free(SifReader *r) {
+    if (!r->borrowed) sif_mem_free(r->alloc, r->data);
+    r->data = NULL;
+    r->length = r->capacity = r->pos = 0;
+}
+
+// make at least min_bytes available after the cursor (fewer only at EOF).
+// Consumed bytes are dropped except one byte of look-behind for reader_unget,
+// and the buffer grows when a single request does not fit.
+static int reader_fill(SifReader *r, size_t min_bytes) {
+    if (r->length - r->pos >= min_bytes) return 0;
+    if (r->eof || (!r->fp && !r->decoder)) return -1;
+
+    size_t keep_from = r->pos > 0 ? r->pos - 1 : 0;
+    if (keep_from > 0) {
+        memmove(r->data, r->data + keep_from, r->length - keep_from);
+        r->length -= keep_from;
+        r->pos -= keep_from;
+        r->base += (long)keep_from;
+    }
+
+    size_t needed = r->pos + min_bytes;
+    if (needed > r->capacity) {
+        size_t new_capacity = r->capacity;
+        while (new_capacity < needed) new_capacity *= 2;
+
+        unsigned char *new_data = sif_mem_realloc(r->alloc, r->data, new_capacity);
+        if (!new_data) return -1;
+        r->data = new_data;
+        r->capacity = new_capacity;
+    }
+
+    // one large read of whatever fits
+    while (r->length - r->pos < min_bytes && !r->eof) {
+        size_t got;
+        if (r->decoder) {
+            int64_t decoded = sif_decoder_pread(r->decoder, r->data + r->length, r->capacity - r->length,
+                                                r->base + (int64_t)r->length);
+            got = decoded > 0 ? (size_t)decoded : 0;
+        } else {
+            got = fread(r->data + r->length, 1, r->capacity - r->length, r->fp);
+        }
+        SIF_STATS_READ(r->stats, got, 1);
+        if (got == 0) r->eof = 1;
+        r->length += got;
+    }
+
+    return (r->length - r->pos >= min_bytes) ? 0 : -1;
+}
+
+static long reader_tell(const SifReader *r) {
+    return r->base + (long)r->pos;
+}
+
+static void reader_seek(SifReader *r, long offset) {
+    if (offset >= r->base && offset <= r->base + (long)r->length) {
+        r->pos = (size_t)(offset - r->base);
+        return;
+    }
+
+    // past the end of an in-memory file: read as EOF from here on
+    if (!r->fp && !r->decoder) {
+        r->pos = offset < r->base ? 0 : r->length;
+        return;
+    }
+
+    // outside the buffered window, restart the buffer at offset
+    if (r->fp) fseek(r->fp, offset, SEEK_SET);
+    SIF_STATS_SEEK(r->stats);
+    r->base = offset;
+    r->length = r->pos = 0;
+    r->eof = 0;
+}
+
+static int reader_getc(SifReader *r) {
+    if (r->pos >= r->length && reader_fill(r, 1) != 0) return EOF;
+    return r->data[r->pos++];
+}
+
+static void reader_unget(SifReader *r) {
+    if (r->pos > 0) r->pos--;
+}
+
+static size_t reader_read(SifReader *r, void *dst, size_t count) {
+    reader_fill(r, count);
+    size_t available = r->length - r->pos;
+    if (count > available) count = available;
+
+    memcpy(dst, r->data + r->pos, count);
+    r->pos += count;
+    return count;
+}
+
+// fgets() on the buffer: up to size-1 bytes, stopping after a newline
+static char *reader_gets(SifReader *r, char *buffer, int size) {
+    if (size <= 0) return NULL;
+
+    int n = 0;
+    while (n < size - 1) {
+        if (r->pos >= r->length && reader_fill(r, 1) != 0) break;
+
+        size_t chunk = r->length - r->pos;
+        if (chunk > (size_t)(size - 1 - n)) chunk = (size_t)(size - 1 - n);
+
+        unsigned char *start = r->data + r->pos;
+        unsigned char *newline = memchr(start, '\n', chunk);
+        if (newline) chunk = (size_t)(newline - start) + 1;
+
+        memcpy(buffer + n, start, chunk);
+        n += (int)chunk;
+        r->pos += chunk;
+        if (newline) break;
+    }
+
+    if (n == 0) return NULL;
+    buffer[n] = '\0';
+    return buffer;
+}
+
 // read line
-static int read_line_directly(FILE *fp, char *buffer, int max_length) {
-    long start_pos = ftell(fp);
-    printf("  Falling back to direct line reading at offset: 0x%lX\n", start_pos);
+static int read_line_directly(SifReader *r, char *buffer, int max_length) {
+    long start_pos = reader_tell(r);
+    PRINT_DEBUG("  Falling back to direct line reading at offset: 0x%lX\n", start_pos);
     
     int i = 0;
-    int c;
+    int c = EOF;
     
     while (i < max_length - 1) {
-        c = fgetc(fp);
+        c = reader_getc(r);
         if (c == EOF || c == '\n' || c == '\r') {
             break;
         }
@@ -116,63 +461,66 @@ static int read_line_directly(FILE *fp, char *buffer, int max_length) {
     
     // deal with carridge return
     if (c == '\r') {
-        c = fgetc(fp);
-        if (c != '\n') {
-            ungetc(c, fp);
+        c = reader_getc(r);
+        if (c != '\n' && c != EOF) {
+            reader_unget(r);
         }
     }
     
-    printf("  Directly read string: '");
-    for (int j = 0; j < i && j < 50; j++) {
-        if (isprint((unsigned char)buffer[j])) {
-            printf("%c", buffer[j]);
-        } else {
-            printf("\\x%02X", (unsigned char)buffer[j]);
+    if (SIF_LOG_ENABLED(SIF_DEBUG)) {
+        PRINT_DEBUG("  Directly read string: '");
+        for (int j = 0; j < i && j < 50; j++) {
+            if (isprint((unsigned char)buffer[j])) {
+                PRINT_DEBUG("%c", buffer[j]);
+            } else {
+                PRINT_DEBUG("\\x%02X", (unsigned char)buffer[j]);
+            }
         }
+        if (i > 50) PRINT_DEBUG("...");
+        PRINT_DEBUG("' (length: %d)\n", i);
     }
-    if (i > 50) printf("...");
-    printf("' (length: %d)\n", i);
     
     return i;
 }
 
-static int read_binary_string(FILE *fp, char *buffer, int max_length, int length) {
+static int read_binary_string(SifReader *r, char *buffer, int max_length, int length) {
     if (length <= 0 || length >= max_length) {
         return -1;
     }
     
-    if (fread(buffer, 1, length, fp) != length) {
+    if (reader_read(r, buffer, length) != (size_t)length) {
         return -1;
     }
     buffer[length] = '\0';
     
-    printf("  Read binary string: ");
-    for (int i = 0; i < length && i < 50; i++) {
-        if (isprint((unsigned char)buffer[i])) {
-            printf("%c", buffer[i]);
-        } else {
-            printf("\\x%02X", (unsigned char)buffer[i]);
+    if (SIF_LOG_ENABLED(SIF_DEBUG)) {
+        PRINT_DEBUG("  Read binary string: ");
+        for (int i = 0; i < length && i < 50; i++) {
+            if (isprint((unsigned char)buffer[i])) {
+                PRINT_DEBUG("%c", buffer[i]);
+            } else {
+                PRINT_DEBUG("\\x%02X", (unsigned char)buffer[i]);
+            }
         }
+        PRINT_DEBUG(" (length: %d)\n", length);
     }
-    printf(" (length: %d)\n", length);
     
     return length;
 }
 
-static int read_line_with_binary_check(FILE *fp, char *buffer, int max_length) {
-    long start_pos = ftell(fp);
+static int read_line_with_binary_check(SifReader *r, char *buffer, int max_length) {
     int i = 0;
     int c;
     
     while (i < max_length - 1) {
-        c = fgetc(fp);
+        c = reader_getc(r);
         if (c == EOF) break;
         if (c == '\n') break;
         
         // check if binary data is met
         if (c < 32 && c != '\t' && c != '\r') {
             // move back and stop reading
-            fseek(fp, -1, SEEK_CUR);
+            reader_unget(r);
             break;
         }
         
@@ -183,6 +531,67 @@ static int read_line_with_binary_check(FILE *fp, char *buffer, int max_length) {
     return i;
 }
 
+// buffered counterpart of read_until()
+static int reader_read_until(SifReader *r, char *buffer, int max_length, char terminator) {
+    int i = 0;
+    int c = 0;
+    long start_pos = reader_tell(r);
+
+    while (i < max_length - 1) {
+        c = reader_getc(r);
+        if (c == EOF) {
+            return -1; // EOF
+        }
+        
+        // encounter terminator/ newline
+        if (c == terminator || c == '\n') {
+            if (i > 0) break; // stop reading until terminator is met
+            // if space / change line and no effective data, and then continue
+            if (c != '\n') continue;
+            else break; // newline is the end of a line, stops even word is empty
+        }
+        
+        buffer[i++] = (char)c;
+    }
+    
+    buffer[i] = '\0';
+    
+    // same cursor rules as read_until()
+    if (c == '\n' && i == 0) {
+        if (reader_tell(r) > start_pos + 1) reader_unget(r);
+    } else if (c != terminator && c != '\n') {
+        if (reader_tell(r) > start_pos) reader_unget(r);
+    }
+
+    return i;
+}
+
+static int reader_read_int(SifReader *r) {
+    char buffer[32];
+    if (reader_read_until(r, buffer, sizeof(buffer), ' ') < 0) {
+        return -1;
+    }
+    return atoi(buffer);
+}
+
+static double reader_read_float(SifReader *r) {
+    char buffer[64];
+    if (reader_read_until(r, buffer, sizeof(buffer), ' ') < 0) {
+        return NAN;
+    }
+    return atof(buffer);
+}
+
+static void reader_skip_spaces(SifReader *r) {
+    while (1) {
+        if (r->pos >= r->length && reader_fill(r, 1) != 0) break;
+
+        unsigned char c = r->data[r->pos];
+        if (c != ' ' && c != '\n' && c != '\r') break;
+        r->pos++;
+    }
+}
+
 // read until terminator
 int read_until(FILE *fp, char *buffer, int max_length, char terminator) {
     int i = 0;
@@ -251,164 +660,393 @@ void skip_spaces(FILE *fp) {
     }
 }
 
-static void discard_line(FILE *fp) {
+static void discard_line(SifReader *r) {
     char buffer[MAX_STRING_LENGTH];
-    if (fgets(buffer, MAX_STRING_LENGTH, fp) == NULL) {
+    if (reader_gets(r, buffer, MAX_STRING_LENGTH) == NULL) {
         // if reaches EOF, noithing
     }
 }
 
-static void discard_bytes(FILE *fp, long count) {
-    fseek(fp, count, SEEK_CUR);
+static void discard_bytes(SifReader *r, long count) {
+    if (reader_fill(r, (size_t)count) != 0) {
+        r->pos = r->length;
+        return;
+    }
+    r->pos += (size_t)count;
+}
+
+// skip whole lines by scanning the buffer for newlines, no copying
+static void discard_lines(SifReader *r, int count) {
+    while (count > 0) {
+        if (r->pos >= r->length && reader_fill(r, 1) != 0) return;
+
+        unsigned char *newline = memchr(r->data + r->pos, '\n', r->length - r->pos);
+        if (newline) {
+            r->pos = (size_t)(newline - r->data) + 1;
+            count--;
+        } else {
+            r->pos = r->length;
+        }
+    }
+}
+
+// timestamp lines in a buffer: lines are found with memchr and each one
+// parsed in place like atoll (blanks, sign, digits). Stops after count lines
+// or at the last complete line; returns the bytes consumed.
+static size_t parse_timestamp_lines(const unsigned char *text, size_t length, int64_t *timestamps,
+                                    int count, int *parsed) {
+    const unsigned char *p = text;
+    const unsigned char *end = text + length;
+
+    while (*parsed < count && p < end) {
+        const unsigned char *newline = memchr(p, '\n', (size_t)(end - p));
+        if (!newline) break;
+
+        const unsigned char *c = p;
+        while (c < newline && (*c == ' ' || *c == '\t' || *c == '\r' || *c == '\v' || *c == '\f')) c++;
+
+        int negative = 0;
+        if (c < newline && (*c == '-' || *c == '+')) {
+            negative = *c == '-';
+            c++;
+        }
+
+        uint64_t value = 0;
+        while (c < newline && (unsigned)(*c - '0') < 10) {
+            value = value * 10 + (uint64_t)(*c - '0');
+            c++;
+        }
+
+        timestamps[(*parsed)++] = negative ? -(int64_t)value : (int64_t)value;
+        p = newline + 1;
+    }
+
+    return (size_t)(p - text);
+}
+
+// timestamp block straight out of the reader's buffer, refilling as needed;
+// frames without a line read as 0. Returns the number of lines parsed.
+static int read_timestamps(SifReader *r, int64_t *timestamps, int count) {
+    int parsed = 0;
+
+    while (parsed < count) {
+        size_t available = r->length - r->pos;
+        r->pos += parse_timestamp_lines(r->data + r->pos, available, timestamps, count, &parsed);
+        if (parsed == count) break;
+
+        // a partial line (or nothing) left: pull in more behind it
+        size_t rest = r->length - r->pos;
+        if (reader_fill(r, rest + 1) != 0) {
+            if (r->pos < r->length) {  // last line without a newline, as fgets
+                unsigned char line[64];
+                size_t n = r->length - r->pos < sizeof(line) - 1 ? r->length - r->pos : sizeof(line) - 1;
+                memcpy(line, r->data + r->pos, n);
+                line[n] = '\n';
+                parse_timestamp_lines(line, n + 1, timestamps, count, &parsed);
+                r->pos = r->length;
+            }
+            break;
+        }
+    }
+
+    for (int f = parsed; f < count; f++) {
+        timestamps[f] = 0;
+    }
+    return parsed;
 }
 
+const SifOpenOptions SIF_DEFAULT_OPEN_OPTIONS = {
+    .keep_user_text = 0,
+    .log = NULL,
+    .trace_events = 0,
+    .lazy_timestamps = 0,
+    .allocator = NULL,
+    .use_arena = 0
+};
+
 // main parsing function
 int sif_open(FILE *fp, SifFile *sif_file) {
+    return sif_open_ex(fp, sif_file, SIF_DEFAULT_OPEN_OPTIONS);
+}
 
-    if (!fp || !sif_file) return -1;
-    
+// the metadata parse_header starts from
+static void init_sif_info(SifInfo *info) {
+    info->raman_ex_wavelength = NAN;
+    info->detector_type = sif_intern("");
+    info->original_filename = sif_intern("");
+    info->spectrograph = sif_intern("");
+    info->frame_axis = sif_intern("");
+    info->data_type = sif_intern("");
+    info->image_axis = sif_intern("");
+    info->calibration_data = NULL;
+    info->calibration_coeff_count = 0;
+    info->has_frame_calibrations = 0;
+}
+
+// reset a handle to the state parse_header starts from
+static int open_handle(SifFile *sif_file, FILE *fp, SifOpenOptions options) {
     SifInfo *info = &sif_file->info;
-    memset(info, 0, sizeof(SifInfo));
 
     memset(sif_file, 0, sizeof(SifFile));
+    pthread_mutex_init(&info->calibration_lock, NULL);
     sif_file->file_ptr = fp;
-    
-    // initialize SifInfo internal pointer
-    memset(&sif_file->info, 0, sizeof(SifInfo));
+    sif_file->lazy_timestamps = options.lazy_timestamps;
+    // without keep_user_text the raw user text is only read for the
+    // calibration parse and dropped after it
+    info->user_text_kept = options.keep_user_text;
+
+    init_sif_info(info);
+    sif_set_log_sink(sif_file, options.log);
+#ifdef SIF_ENABLE_STATS
+    sif_file->stats = sif_stats_create(options.trace_events);
+    info->stats = sif_file->stats;
+#endif
+
+    if (options.allocator || options.use_arena) {
+        info->alloc = sif_alloc_create(options.allocator, options.use_arena);
+        if (!info->alloc) {
+            fprintf(stderr, "Error: Cannot set up the handle's allocator\n");
+            return -1;
+        }
+    }
+    return 0;
+}
 
-    info->raman_ex_wavelength = NAN;
-    info->calibration_data[0] = '\0';  
-    info->calibration_coeff_count = 0;
-    info->has_frame_calibrations = 0;
+// a failed open releases everything it set up (tables, interned strings,
+// counters, allocator, decoder) and leaves a blank handle behind
+static int fail_open(SifFile *sif_file) {
+    sif_close(sif_file);
+    memset(sif_file, 0, sizeof(SifFile));
+    return -1;
+}
+
+// full header parse over a prepared reader
+static int parse_handle(SifFile *sif_file, SifReader *reader, SifOpenOptions options) {
+    SifInfo *info = &sif_file->info;
+    reader->stats = sif_file->stats;
+
+    SIF_STATS_START(parse_start);
+    const SifLogSink *previous_log = sif_log_enter(info);
+    int result = parse_header(reader, sif_file, 0, options.lazy_timestamps);
+    sif_log_leave(previous_log);
+    SIF_STATS_PHASE(sif_file->stats, SIF_PHASE_HEADER_PARSE, parse_start, (uint64_t)reader_tell(reader));
+
+    return result;
+}
+
+int sif_open_ex(FILE *fp, SifFile *sif_file, SifOpenOptions options) {
+
+    if (!fp || !sif_file) return -1;
+
+    if (open_handle(sif_file, fp, options) != 0) return fail_open(sif_file);
+
+    SifReader reader;
+    if (reader_init_file(&reader, sif_file, fp, SIF_READER_CHUNK) != 0) {
+        return fail_open(sif_file);
+    }
+
+    int result = parse_handle(sif_file, &reader, options);
+
+    // leave the stream where the header parse stopped (a compressed
+    // file's offsets do not apply to it)
+    if (!sif_file->decoder) {
+        fseek(fp, reader_tell(&reader), SEEK_SET);
+        SIF_STATS_SEEK(sif_file->stats);
+    }
+    reader_free(&reader);
+    if (result != 0) {
+        return fail_open(sif_file);
+    }
+
+    return 0;
+}
+
+int sif_open_memory(const void *buffer, size_t length, SifFile *sif_file) {
+    return sif_open_memory_ex(buffer, length, sif_file, SIF_DEFAULT_OPEN_OPTIONS);
+}
+
+// parse a file image held by the caller. It stands in for a file mapping:
+// frames in native byte order are served from it in place, everything else
+// is copied out of it, so it must outlive the handle.
+int sif_open_memory_ex(const void *buffer, size_t length, SifFile *sif_file, SifOpenOptions options) {
+    if (!buffer || length == 0 || !sif_file) return -1;
+
+    if (open_handle(sif_file, NULL, options) != 0) return fail_open(sif_file);
+
+    SifReader reader;
+    reader_init_memory(&reader, buffer, length);
+    int result = parse_handle(sif_file, &reader, options);
+    reader_free(&reader);
+    if (result != 0) {
+        return fail_open(sif_file);
+    }
+
+    sif_file->map_base = (void *)buffer;
+    sif_file->map_length = length;
+    sif_file->map_borrowed = 1;
+
+    const SifLogSink *previous_log = sif_log_enter(&sif_file->info);
+    if (map_frame_data(sif_file) == 0) {
+        PRINT_VERBOSE("✓ Frame data accessible in place at offset 0x%lX\n", sif_file->info.data_offset);
+    } else {
+        PRINT_VERBOSE("  Frame data not usable in place, frames will be copied from the buffer\n");
+    }
+    sif_log_leave(previous_log);
+
+    return 0;
+}
 
+static int parse_header(SifReader *r, SifFile *sif_file, int header_only, int lazy_timestamps) {
+
+    SifInfo *info = &sif_file->info;
     
-    PRINT_NORMAL("=== Starting SIF File Parsing ===\n");
+    if (!header_only) {
+        PRINT_NORMAL("=== Starting SIF File Parsing ===\n");
+    }
     
     char line_buffer[MAX_STRING_LENGTH];
     
     // Line 1: Magic string
-    if (fread(line_buffer, 1, 36, fp) != 36 || strncmp(line_buffer, SIF_MAGIC, 36) != 0) {
-        fprintf(stderr, "Error: Not a SIF file or invalid magic string\n");
+    if (reader_read(r, line_buffer, 36) != 36 || strncmp(line_buffer, SIF_MAGIC, 36) != 0) {
+        // probing is expected to meet other files, stay quiet there
+        if (!header_only) {
+            fprintf(stderr, "Error: Not a SIF file or invalid magic string\n");
+        }
         return -1;
     }
     PRINT_VERBOSE("✓ Line 1: Valid magic string\n");
 
     // Line 2: Skip
-    discard_line(fp); 
+    discard_line(r); 
 
     // Line 3: Structured data
     PRINT_VERBOSE("→ Line 3: Parsing structured data...\n");
     
-    long line3_start = ftell(fp);
+    long line3_start = reader_tell(r);
     PRINT_VERBOSE("  Line 3 starts at offset: 0x%lX\n", line3_start);
 
-    info->sif_version = read_int(fp);
+    info->sif_version = reader_read_int(r);
     
     for (int i = 0; i < 3; i++) {
-        int temp = read_int(fp);
+        int temp = reader_read_int(r);
         PRINT_VERBOSE("  Skipped int %d: %d\n", i, temp);
     }
 
-    info->experiment_time = read_int(fp);
-    info->detector_temperature = read_float(fp);
+    info->experiment_time = reader_read_int(r);
+    info->detector_temperature = reader_read_float(r);
     
-    discard_bytes(fp, 10); // Skip 10-byte padding
+    discard_bytes(r, 10); // Skip 10-byte padding
     
-    read_int(fp); // skip 0
-    info->exposure_time = read_float(fp);
-    info->cycle_time = read_float(fp);
-    info->accumulated_cycle_time = read_float(fp);
-    info->accumulated_cycles = read_int(fp);
+    reader_read_int(r); // skip 0
+    info->exposure_time = reader_read_float(r);
+    info->cycle_time = reader_read_float(r);
+    info->accumulated_cycle_time = reader_read_float(r);
+    info->accumulated_cycles = reader_read_int(r);
     
-    discard_bytes(fp, 2); // skip NULL and space
+    discard_bytes(r, 2); // skip NULL and space
     
-    info->stack_cycle_time = read_float(fp);
-    info->pixel_readout_time = read_float(fp);
+    info->stack_cycle_time = reader_read_float(r);
+    info->pixel_readout_time = reader_read_float(r);
     
-    read_int(fp); // skip 0
-    read_int(fp); // skip 1
-    info->gain_dac = read_float(fp);
+    reader_read_int(r); // skip 0
+    reader_read_int(r); // skip 1
+    info->gain_dac = reader_read_float(r);
     
-    read_int(fp); // skip 0
-    read_int(fp); // skip 0
-    info->gate_width = read_float(fp);
+    reader_read_int(r); // skip 0
+    reader_read_int(r); // skip 0
+    info->gate_width = reader_read_float(r);
     
     // Skip 16 int
     for (int i = 0; i < 16; i++) {
-        read_int(fp);
+        reader_read_int(r);
     }
     
-    info->grating_blaze = read_float(fp);
+    info->grating_blaze = reader_read_float(r);
     
     // read Line 3 until change line
-    if (fgets(line_buffer, sizeof(line_buffer), fp) == NULL) return -1;
+    if (reader_gets(r, line_buffer, sizeof(line_buffer)) == NULL) return -1;
     
     // Line 4: Detector Type
-    if (fgets(info->detector_type, sizeof(info->detector_type), fp) == NULL) return -1;
-    trim_trailing_whitespace(info->detector_type);
+    if (reader_gets(r, line_buffer, sizeof(line_buffer)) == NULL) return -1;
+    trim_trailing_whitespace(line_buffer);
+    info->detector_type = sif_intern(line_buffer);
     PRINT_VERBOSE("✓ Detector Type: '%s'\n", info->detector_type);
 
     // Line 5: Detector Dimensions
-    info->detector_width = read_int(fp);
-    info->detector_height = read_int(fp);
+    info->detector_width = reader_read_int(r);
+    info->detector_height = reader_read_int(r);
     PRINT_VERBOSE("✓ Detector Dimensions: %d x %d\n", info->detector_width, info->detector_height);
 
     // documents reading
     PRINT_VERBOSE("→ Reading original filename...\n");
-    long before_filename = ftell(fp);
+    long before_filename = reader_tell(r);
     PRINT_VERBOSE("  Before filename, position: 0x%lX\n", before_filename);
     
     // read and discard the first line（"45"）
-    if (fgets(line_buffer, sizeof(line_buffer), fp) == NULL) return -1;
+    if (reader_gets(r, line_buffer, sizeof(line_buffer)) == NULL) return -1;
     line_buffer[strcspn(line_buffer, "\r\n")] = 0;
     PRINT_VERBOSE("  Discarded short line: '%s'\n", line_buffer);
     
     // read the real filenmae
-    if (fgets(info->original_filename, sizeof(info->original_filename), fp) == NULL) return -1;
-    trim_trailing_whitespace(info->original_filename);
+    if (reader_gets(r, line_buffer, sizeof(line_buffer)) == NULL) return -1;
+    trim_trailing_whitespace(line_buffer);
+    info->original_filename = sif_intern(line_buffer);
     PRINT_VERBOSE("✓ Original Filename: '%s'\n", info->original_filename);
     
-    PRINT_DEBUG("After original filename parsing, position: 0x%lX\n", ftell(fp));
+    PRINT_DEBUG("After original filename parsing, position: 0x%lX\n", reader_tell(r));
     
     // skip 20 space 0A newline
-    discard_bytes(fp, 2);
+    discard_bytes(r, 2);
 
     // Line 7: should be "65538 2048"
-    int user_text_flag = read_int(fp);
-    int user_text_length = read_int(fp);
+    int user_text_flag = reader_read_int(r);
+    int user_text_length = reader_read_int(r);
     PRINT_DEBUG("  User text flag: %d, length: %d\n", user_text_flag, user_text_length);
 
-    long current_pos = ftell(fp);
+    long current_pos = reader_tell(r);
     PRINT_DEBUG("  After Line 7, position: 0x%lX\n", current_pos);
 
-    // read User Text (if there is)
-    if (user_text_length > 0 && user_text_length < sizeof(info->user_text)) {
-        if (fread(info->user_text, 1, user_text_length, fp) == user_text_length) {
+    // read User Text (if there is); unless it is to be kept only note where
+    // it is, sif_ensure_calibration reads it back when the calibration is needed
+    if ((header_only || !info->user_text_kept) && user_text_length > 0) {
+        sif_file->user_text_offset = reader_tell(r);
+        reader_seek(r, reader_tell(r) + user_text_length);
+        info->user_text_length = user_text_length;
+    } else if (user_text_length > 0) {
+        SIF_STATS_START(user_text_start);
+        info->user_text = sif_mem_alloc(info->alloc, (size_t)user_text_length + 1);
+        SIF_STATS_ALLOC(sif_file->stats, (size_t)user_text_length + 1);
+        if (info->user_text &&
+            reader_read(r, info->user_text, user_text_length) == (size_t)user_text_length) {
             info->user_text[user_text_length] = '\0';
             info->user_text_length = user_text_length;
             PRINT_DEBUG("  User text: %d bytes\n", info->user_text_length);
+        } else {
+            sif_mem_free(info->alloc, info->user_text);
+            info->user_text = NULL;
         }
+        SIF_STATS_PHASE(sif_file->stats, SIF_PHASE_USER_TEXT, user_text_start, (uint64_t)user_text_length);
     }
-    discard_line(fp); // read change line
+    discard_line(r); // read change line
 
     // Line 9: Shutter Time info
     PRINT_VERBOSE("→ Line 9: Reading shutter time...\n");
-    long line9_start = ftell(fp);
+    long line9_start = reader_tell(r);
     PRINT_VERBOSE("  Line 9 starts at offset: 0x%lX\n", line9_start);
 
     // read markers and verify
-    int line9_marker = read_int(fp);
+    int line9_marker = reader_read_int(r);
     if (line9_marker != 65538) {
         PRINT_VERBOSE("  ⚠️ Unexpected marker in Line 9: %d (expected 65538)\n", line9_marker);
     }
 
     PRINT_VERBOSE("  Line 9 marker: %d\n", line9_marker);
 
-    discard_bytes(fp, 8);
+    discard_bytes(r, 8);
     PRINT_VERBOSE("  Skipped 8 bytes\n");
 
-    info->shutter_time[0] = read_float(fp);
-    info->shutter_time[1] = read_float(fp);
+    info->shutter_time[0] = reader_read_float(r);
+    info->shutter_time[1] = reader_read_float(r);
 
     // check if the floating point is valid
     if (isnan(info->shutter_time[0]) || isnan(info->shutter_time[1])) {
@@ -418,114 +1056,114 @@ int sif_open(FILE *fp, SifFile *sif_file) {
 
     PRINT_VERBOSE("✓ Shutter Time: %.6f, %.6f\n", info->shutter_time[0], info->shutter_time[1]);
 
-    skip_spaces(fp); 
-    PRINT_DEBUG("  After Line 9, position: 0x%lX\n", ftell(fp));
+    reader_skip_spaces(r); 
+    PRINT_DEBUG("  After Line 9, position: 0x%lX\n", reader_tell(r));
 
     PRINT_VERBOSE("→ Version-specific skipping logic...\n");
     PRINT_VERBOSE("  SIF Version: %d\n", info->sif_version);
 
     if (info->sif_version >= 65548 && info->sif_version <= 65557) {
         PRINT_VERBOSE("  Version 65548-65557: skipping 2 lines\n");
-        for (int i = 0; i < 2; i++) discard_line(fp);
+        for (int i = 0; i < 2; i++) discard_line(r);
     }
     else if (info->sif_version == 65558) {
         PRINT_VERBOSE("  Version 65558: skipping 5 lines\n");
-        for (int i = 0; i < 5; i++) discard_line(fp);
+        for (int i = 0; i < 5; i++) discard_line(r);
     }
     else if (info->sif_version == 65559 || info->sif_version == 65564) {
         PRINT_VERBOSE("  Version 65559/65564: skipping 8 lines\n");
-        for (int i = 0; i < 8; i++) discard_line(fp);
+        for (int i = 0; i < 8; i++) discard_line(r);
     }
     else if (info->sif_version == 65565) {
         PRINT_VERBOSE("  Version 65565: skipping 15 lines\n");
-        for (int i = 0; i < 15; i++) discard_line(fp);
+        for (int i = 0; i < 15; i++) discard_line(r);
     }
     else if (info->sif_version > 65565) {
         PRINT_VERBOSE("  Version %d > 65565: complex skipping logic\n", info->sif_version);
     
         // Line 10-17: 跳過 8 行
         for (int i = 0; i < 8; i++) {
-            discard_line(fp);
+            discard_line(r);
         }
         PRINT_VERBOSE("  Skipped 8 lines (Line 10-17)\n");
         
         // Line 18: Spectrograph
-        if (fgets(info->spectrograph, sizeof(info->spectrograph), fp) == NULL) return -1;
-        trim_trailing_whitespace(info->spectrograph);
+        if (reader_gets(r, line_buffer, sizeof(line_buffer)) == NULL) return -1;
+        trim_trailing_whitespace(line_buffer);
+        info->spectrograph = sif_intern(line_buffer);
         PRINT_VERBOSE("✓ Spectrograph: '%s'\n", info->spectrograph);
         
         // Line 19: Intensifier info -> skip
-        discard_line(fp);
+        discard_line(r);
         PRINT_VERBOSE("  Skipped intensifier info line\n");
         
         // Line 20-22: read 3 floats (perhaps extra params)
         for (int i = 0; i < 3; i++) {
-            read_float(fp); 
+            reader_read_float(r); 
         }
         PRINT_VERBOSE("  Read 3 float parameters\n");
         
         // Line 23: Gate Gain
-        info->gate_gain = read_float(fp);
+        info->gate_gain = reader_read_float(r);
         PRINT_VERBOSE("✓ Gate Gain: %.6f\n", info->gate_gain);
         
         // Line 24-25: read 2 floats
-        read_float(fp);
-        read_float(fp);
+        reader_read_float(r);
+        reader_read_float(r);
         PRINT_VERBOSE("  Read 2 additional float parameters\n");
         
         // Line 26: Gate Delay (picoseconds to seconds)
-        float gate_delay_ps = read_float(fp);
+        float gate_delay_ps = reader_read_float(r);
         info->gate_delay = gate_delay_ps * 1e-12;
         PRINT_VERBOSE("✓ Gate Delay: %.6f ps (%.2e s)\n", gate_delay_ps, info->gate_delay);
         
         // Line 27: Gate Width (picoseconds to seconds)  
-        float gate_width_ps = read_float(fp);
+        float gate_width_ps = reader_read_float(r);
         info->gate_width = gate_width_ps * 1e-12;
         PRINT_VERBOSE("✓ Gate Width: %.6f ps (%.2e s)\n", gate_width_ps, info->gate_width);
         
         // Line 28-35: skip 8 lines
         for (int i = 0; i < 8; i++) {
-            discard_line(fp);
+            discard_line(r);
         }
         PRINT_DEBUG("  Skipped 8 lines (Line 28-35)\n");
     }
 
-    PRINT_DEBUG("  After version skipping, position: 0x%lX\n", ftell(fp));
+    PRINT_DEBUG("  After version skipping, position: 0x%lX\n", reader_tell(r));
     
     PRINT_VERBOSE("→ Reading calibration and additional data...\n");
 
-    info->sif_calb_version = read_int(fp);
+    info->sif_calb_version = reader_read_int(r);
     PRINT_NORMAL("✓ SIF Calibration Version: %d\n", info->sif_calb_version);
 
     if (info->sif_calb_version == 65540) {
-        discard_line(fp);
+        discard_line(r);
         PRINT_DEBUG("  Skipped line for calibration version 65540\n");
     }
 
     // calibration data
     char calib_line[MAX_STRING_LENGTH];
-    if (fgets(calib_line, sizeof(calib_line), fp) == NULL) {
+    if (reader_gets(r, calib_line, sizeof(calib_line)) == NULL) {
         PRINT_DEBUG("  Warning: Failed to read calibration data line\n");
-        info->calibration_data[0] = '\0'; // set to be an empty string
+        info->calibration_data = NULL;
     } else {
         trim_trailing_whitespace(calib_line);
         PRINT_VERBOSE("✓ Calibration Data: %s\n", calib_line);
         
-        // correct copy to struct
-        strncpy(info->calibration_data, calib_line, sizeof(info->calibration_data) - 1);
-        info->calibration_data[sizeof(info->calibration_data) - 1] = '\0';
+        // copy to struct, sized to the line
+        info->calibration_data = sif_mem_strdup(info->alloc, calib_line);
     }
 
-    discard_line(fp);
+    discard_line(r);
     PRINT_VERBOSE("  Skipped old calibration data\n");
 
     char extra_line[MAX_STRING_LENGTH];
-    if (fgets(extra_line, sizeof(extra_line), fp) == NULL) return -1;
+    if (reader_gets(r, extra_line, sizeof(extra_line)) == NULL) return -1;
     trim_trailing_whitespace(extra_line);
     PRINT_VERBOSE("  Extra Data: %s\n", extra_line);
 
     char raman_line[MAX_STRING_LENGTH];
-    if (fgets(raman_line, sizeof(raman_line), fp) == NULL) return -1;
+    if (reader_gets(r, raman_line, sizeof(raman_line)) == NULL) return -1;
 
     // direct use the line that fgets read, strtod will automatically deal with the Newline
     char *endptr;
@@ -542,38 +1180,43 @@ int sif_open(FILE *fp, SifFile *sif_file) {
 
     PRINT_DEBUG("→ Skipping 4 lines after Raman wavelength...\n");
     for (int i = 0; i < 4; i++) {
-        discard_line(fp);
+        discard_line(r);
     }
 
-    long after_calib_pos = ftell(fp);
+    long after_calib_pos = reader_tell(r);
     PRINT_DEBUG("  Skipped 4 lines position: 0x%lX\n", after_calib_pos);
 
     // Frame Axis, Data Type, Image Axis
     PRINT_VERBOSE("→ Reading axes as simple text lines...\n");
 
-    if (fgets(info->frame_axis, sizeof(info->frame_axis), fp) == NULL) return -1;
-    trim_trailing_whitespace(info->frame_axis);
-    PRINT_VERBOSE("  Raw Frame Axis: '%s'\n", info->frame_axis);
+    char frame_axis[MAX_STRING_LENGTH];
+    if (reader_gets(r, frame_axis, sizeof(frame_axis)) == NULL) return -1;
+    trim_trailing_whitespace(frame_axis);
+    PRINT_VERBOSE("  Raw Frame Axis: '%s'\n", frame_axis);
 
-    if (fgets(info->data_type, sizeof(info->data_type), fp) == NULL) return -1;
-    trim_trailing_whitespace(info->data_type);
-    PRINT_VERBOSE("  Raw Data Type: '%s'\n", info->data_type);
+    char data_type[MAX_STRING_LENGTH];
+    if (reader_gets(r, data_type, sizeof(data_type)) == NULL) return -1;
+    trim_trailing_whitespace(data_type);
+    PRINT_VERBOSE("  Raw Data Type: '%s'\n", data_type);
 
-    if (fgets(info->image_axis, sizeof(info->image_axis), fp) == NULL) return -1;
-    trim_trailing_whitespace(info->image_axis);
-    PRINT_VERBOSE("  Raw Image Axis: '%s'\n", info->image_axis);
+    char image_axis[MAX_STRING_LENGTH];
+    if (reader_gets(r, image_axis, sizeof(image_axis)) == NULL) return -1;
+    trim_trailing_whitespace(image_axis);
+    PRINT_VERBOSE("  Raw Image Axis: '%s'\n", image_axis);
 
     // Extract the plain text content
-    extract_text_part_robust(info->frame_axis, info->frame_axis, sizeof(info->frame_axis)); 
-    extract_text_part_robust(info->data_type, info->data_type, sizeof(info->data_type));  
+    extract_text_part_robust(frame_axis, frame_axis, sizeof(frame_axis)); 
+    extract_text_part_robust(data_type, data_type, sizeof(data_type));  
+    info->frame_axis = sif_intern(frame_axis);
+    info->data_type = sif_intern(data_type);
 
     // keep the text as a temporary variable, temp
     char temp[MAX_STRING_LENGTH];
-    extract_text_part_robust(info->image_axis, temp, sizeof(temp));
+    extract_text_part_robust(image_axis, temp, sizeof(temp));
     PRINT_VERBOSE("  Text part: '%s'\n", temp);
 
     // keep number from the temp 
-    char *number_part = info->image_axis + strlen(temp);
+    char *number_part = image_axis + strlen(temp);
     PRINT_VERBOSE("  Number part: '%s'\n", number_part);
 
     PRINT_VERBOSE("✓ Frame Axis: '%s'\n", info->frame_axis);
@@ -581,11 +1224,11 @@ int sif_open(FILE *fp, SifFile *sif_file) {
 
     // number parsing
     char *token = strtok(number_part, " ");
-    int values[9];
+    int64_t values[9];
     int value_count = 0;
 
     while (token && value_count < 9) {
-        values[value_count] = atoi(token);
+        values[value_count] = strtoll(token, NULL, 10);
         value_count++;
         token = strtok(NULL, " ");
     }
@@ -593,43 +1236,52 @@ int sif_open(FILE *fp, SifFile *sif_file) {
     int layout_marker = 0;
 
     if (value_count >= 9) {
-        layout_marker = values[0];
+        layout_marker = (int)values[0];
 
-        info->number_of_frames = values[5];
-        info->number_of_subimages = values[6];
+        info->number_of_frames = (int)values[5];
+        info->number_of_subimages = (int)values[6];
         info->total_length = values[7];
         info->image_length = values[8];
         
     }
     
-    // now can safely write the string to image_axis
-    strcpy(info->image_axis, temp);
+    // now can safely store the text part as image_axis
+    info->image_axis = sif_intern(temp);
     PRINT_VERBOSE("✓ Image Axis: '%s'\n", info->image_axis);
 
     PRINT_VERBOSE("✓ Image info:\n");
     PRINT_VERBOSE("  %-15s %d\n", "Frames:", info->number_of_frames);
     PRINT_VERBOSE("  %-15s %d\n", "Subimages:", info->number_of_subimages);
-    PRINT_VERBOSE("  %-15s %d\n", "Total length:", info->total_length);
-    PRINT_VERBOSE("  %-15s %d\n", "Image length:", info->image_length);
+    PRINT_VERBOSE("  %-15s %" PRId64 "\n", "Total length:", info->total_length);
+    PRINT_VERBOSE("  %-15s %" PRId64 "\n", "Image length:", info->image_length);
 
     if (info->number_of_subimages > 0) {
         PRINT_DEBUG("→ Reading %d subimage(s) for binning information...\n", info->number_of_subimages);
         
-        info->subimages = malloc(info->number_of_subimages * sizeof(SubImageInfo));
+        SubImageInfo probe_sub;
+        if (!header_only) {
+            info->subimages = take_buffer(sif_file, &sif_file->spare_subimages,
+                                          info->number_of_subimages * sizeof(SubImageInfo));
+            if (!info->subimages) {
+                PRINT_DEBUG("❌ Failed to allocate memory for subimages\n");
+                return -1;
+            }
+        }
+        info->pixels_per_frame = 0;
         
         for (int i = 0; i < info->number_of_subimages; i++) {
-            SubImageInfo *sub = &info->subimages[i];
+            SubImageInfo *sub = header_only ? &probe_sub : &info->subimages[i];
             
-            int sub_marker = read_int(fp);
+            int sub_marker = reader_read_int(r);
             PRINT_DEBUG("  Subimage %d marker: %d\n", i, sub_marker);
             
             // read suimage and binning
-            sub->x0 = read_int(fp);
-            sub->y1 = read_int(fp);
-            sub->x1 = read_int(fp);
-            sub->y0 = read_int(fp);
-            sub->ybin = read_int(fp);  
-            sub->xbin = read_int(fp);  
+            sub->x0 = reader_read_int(r);
+            sub->y1 = reader_read_int(r);
+            sub->x1 = reader_read_int(r);
+            sub->y0 = reader_read_int(r);
+            sub->ybin = reader_read_int(r);  
+            sub->xbin = reader_read_int(r);  
             
             PRINT_DEBUG("    Area: (%d,%d)-(%d,%d), Binning: %dx%d\n",
                 sub->x0, sub->y0, sub->x1, sub->y1, sub->xbin, sub->ybin);
@@ -639,6 +1291,10 @@ int sif_open(FILE *fp, SifFile *sif_file) {
             sub->height = (1 + sub->y1 - sub->y0) / sub->ybin;
             
             PRINT_DEBUG("    Size: %dx%d\n", sub->width, sub->height);
+
+            // tracks are stored one after another within each frame
+            sub->offset = info->pixels_per_frame;
+            info->pixels_per_frame += (size_t)sub->width * sub->height;
             
             // set the global scope binning 
             if (i == 0) {
@@ -652,39 +1308,50 @@ int sif_open(FILE *fp, SifFile *sif_file) {
         PRINT_VERBOSE("✓ Final image configuration:\n");
         PRINT_VERBOSE("  Size: %dx%d pixels\n", info->image_width, info->image_height);
         PRINT_VERBOSE("  Binning: %dx%d\n", info->xbin, info->ybin);
+        PRINT_VERBOSE("  Pixels per frame: %zu (%d track(s))\n", info->pixels_per_frame, info->number_of_subimages);
+    } else {
+        info->pixels_per_frame = (size_t)info->image_width * info->image_height;
     }
 
-    PRINT_DEBUG("  After layout parsing, position: 0x%lX\n", ftell(fp));
+    PRINT_DEBUG("  After layout parsing, position: 0x%lX\n", reader_tell(r));
    
     PRINT_DEBUG("→ Reading timestamps for %d frames...\n", info->number_of_frames);
 
-    discard_line(fp);
-    PRINT_DEBUG("  After skipping a line, position: 0x%lX\n", ftell(fp));
+    discard_line(r);
+    PRINT_DEBUG("  After skipping a line, position: 0x%lX\n", reader_tell(r));
 
     // read timestamps
-    if (info->number_of_frames > 0) {
-        info->timestamps = malloc(info->number_of_frames * sizeof(int64_t));
+    SIF_STATS_START(timestamps_start);
+    if (header_only) {
+        discard_lines(r, info->number_of_frames);
+    } else if (lazy_timestamps) {
+        // only the block's byte range; sif_get_timestamps decodes it
+        sif_file->timestamp_offset = reader_tell(r);
+        discard_lines(r, info->number_of_frames);
+        sif_file->timestamp_length = (size_t)(reader_tell(r) - sif_file->timestamp_offset);
+        PRINT_VERBOSE("  Timestamps: %zu bytes at 0x%" PRIX64 ", decoded on first access\n",
+                      sif_file->timestamp_length, sif_file->timestamp_offset);
+    } else if (info->number_of_frames > 0) {
+        info->timestamps = take_buffer(sif_file, &sif_file->spare_timestamps,
+                                       info->number_of_frames * sizeof(int64_t));
         if (!info->timestamps) {
             PRINT_DEBUG("❌ Failed to allocate memory for timestamps\n");
             return -1;
         }
         
-        for (int f = 0; f < info->number_of_frames; f++) {
-            char timestamp_str[64];
-            if (fgets(timestamp_str, sizeof(timestamp_str), fp) == NULL) {
-                PRINT_DEBUG("❌ Failed to read timestamp for frame %d\n", f);
-                info->timestamps[f] = 0;
-            } else {
-                info->timestamps[f] = atoll(timestamp_str);
-                PRINT_VERBOSE("  Frame %d timestamp: %" PRId64 "\n", f, info->timestamps[f]);
-            }
+        int parsed = read_timestamps(r, info->timestamps, info->number_of_frames);
+        if (parsed < info->number_of_frames) {
+            PRINT_DEBUG("❌ Only %d/%d timestamps present, the rest are 0\n", parsed, info->number_of_frames);
         }
+        PRINT_VERBOSE("  Timestamps: %d, first %" PRId64 ", last %" PRId64 "\n", info->number_of_frames,
+                      info->timestamps[0], info->timestamps[info->number_of_frames - 1]);
     }
-    PRINT_DEBUG("  After timestamps, position: 0x%lX\n", ftell(fp));
+    SIF_STATS_PHASE(sif_file->stats, SIF_PHASE_TIMESTAMPS, timestamps_start, 0);
+    PRINT_DEBUG("  After timestamps, position: 0x%lX\n", reader_tell(r));
 
     PRINT_VERBOSE("→ Determining data offset...\n");
 
-    long before_data = ftell(fp);
+    long before_data = reader_tell(r);
     info->data_offset = before_data; // default data offset
 
     // check extra flags or not
@@ -692,7 +1359,7 @@ int sif_open(FILE *fp, SifFile *sif_file) {
 
     PRINT_DEBUG("→ Reading data flag line at position: 0x%lX\n", before_data);
 
-    if (fgets(line, sizeof(line), fp) != NULL) {
+    if (reader_gets(r, line, sizeof(line)) != NULL) {
         // kill NewLine
         line[strcspn(line, "\n")] = '\0';
         
@@ -704,118 +1371,288 @@ int sif_open(FILE *fp, SifFile *sif_file) {
             PRINT_VERBOSE("  Parsed data flag: %d\n", data_flag);
             
             if (data_flag == 0) {
-                info->data_offset = ftell(fp);  // now moves to the first char of the line
+                info->data_offset = reader_tell(r);  // now moves to the first char of the line
                 PRINT_DEBUG("✓ Data starts after flag 0 at offset: 0x%lX\n", info->data_offset);
             } else if (data_flag == 1 && info->sif_version == 65567) {
                 PRINT_DEBUG("  SIF 65567: skipping %d additional lines\n", info->number_of_frames);
-                for (int i = 0; i < info->number_of_frames; i++) {
-                    if (fgets(line, sizeof(line), fp) == NULL) break;
-                    PRINT_DEBUG("    Skipped line %d: '%s'\n", i, line);
+                if (header_only) {
+                    discard_lines(r, info->number_of_frames);
+                } else {
+                    for (int i = 0; i < info->number_of_frames; i++) {
+                        if (reader_gets(r, line, sizeof(line)) == NULL) break;
+                        PRINT_DEBUG("    Skipped line %d: '%s'\n", i, line);
+                    }
                 }
-                info->data_offset = ftell(fp);
+                info->data_offset = reader_tell(r);
                 PRINT_DEBUG("✓ Data starts after version-specific data at offset: 0x%lX\n", info->data_offset);
             } else {
                 // other condition, go back to the original position
-                fseek(fp, before_data, SEEK_SET);
+                reader_seek(r, before_data);
                 PRINT_DEBUG("✓ Data starts at original offset: 0x%lX\n", info->data_offset);
             }
         } else {
             // int parsing fails
             PRINT_DEBUG("  Failed to parse integer from line\n");
-            fseek(fp, before_data, SEEK_SET);
+            reader_seek(r, before_data);
             PRINT_DEBUG("✓ Data starts at original offset: 0x%lX\n", info->data_offset);
         }
     } else {
         PRINT_DEBUG("  Failed to read line\n");
-        fseek(fp, before_data, SEEK_SET);
+        reader_seek(r, before_data);
         PRINT_DEBUG("✓ Data starts at original offset: 0x%lX\n", info->data_offset);
     }
         
-    PRINT_VERBOSE("→ Initializing SifFile structure and tiles...\n");
+    PRINT_VERBOSE("→ Initializing SifFile structure...\n");
 
     sif_file->frame_count = info->number_of_frames;
-    sif_file->tile_count = info->number_of_frames;
-    
-    // allocate and initiate tiles
-    if (sif_file->tile_count > 0) {
-        sif_file->tiles = malloc(sif_file->tile_count * sizeof(ImageTile));
-        if (sif_file->tiles) {
-            // compute the size of each frame（width*height*no_subimages*4）
-            int pixels_per_frame = info->image_width * info->image_height * info->number_of_subimages;
-            int bytes_per_pixel = 4; // 32-bit float 
-            
-            PRINT_VERBOSE("  Tile configuration:\n");
-            PRINT_VERBOSE("    Pixels per frame: %d\n", pixels_per_frame);
-            PRINT_VERBOSE("    Bytes per pixel: %d\n", bytes_per_pixel);
-            PRINT_VERBOSE("    Total bytes per frame: %d\n", pixels_per_frame * bytes_per_pixel);
-            
-            for (int f = 0; f < sif_file->tile_count; f++) {
-                sif_file->tiles[f].offset = info->data_offset + f * pixels_per_frame * bytes_per_pixel;
-                sif_file->tiles[f].width = info->image_width;
-                sif_file->tiles[f].height = info->image_height;
-                sif_file->tiles[f].frame_index = f;
-                
-                PRINT_VERBOSE("    Tile %d: offset=0x%08lX, size=%dx%d\n", 
-                    f, sif_file->tiles[f].offset,
-                    sif_file->tiles[f].width, sif_file->tiles[f].height);
-            }
-            PRINT_VERBOSE("✓ Allocated %d image tiles\n", sif_file->tile_count);
-        } else {
-            printf("❌ Failed to allocate memory for tiles\n");
-            return -1;
-        }
-    }
-
-    PRINT_VERBOSE("  Before extract_user_text:\n");
-    PRINT_VERBOSE("    user_text pointer: %p\n", info->user_text);
-    PRINT_VERBOSE("    user_text[0]: 0x%02X\n", (unsigned char)info->user_text[0]);
-    PRINT_VERBOSE("    strlen(user_text): %lu\n", strlen(info->user_text));
-    PRINT_VERBOSE("    user_text_length: %d\n", info->user_text_length);
 
-    // manual check the first 10 bytes
-    PRINT_VERBOSE("    First 10 bytes: ");
-    for (int i = 0; i < 10 && i < user_text_length; i++) {
-        PRINT_VERBOSE("%02X ", (unsigned char)info->user_text[i]);
+    if (header_only) {
+        return 0;
     }
-    PRINT_VERBOSE("\n");
 
-    // clean and retriecve the calibration data
-    extract_user_text(info);
+    // frames sit back to back from data_offset, their offsets are computed
+    // on demand (sif_frame_offset) rather than stored per frame
+    PRINT_VERBOSE("  Frame layout:\n");
+    PRINT_VERBOSE("    Pixels per frame: %zu\n", info->pixels_per_frame);
+    PRINT_VERBOSE("    Bytes per frame: %zu\n", info->pixels_per_frame * sizeof(float));
+    PRINT_VERBOSE("    Data size: %" PRId64 " bytes\n",
+        (int64_t)sif_file->frame_count * (int64_t)(info->pixels_per_frame * sizeof(float)));
+
+    // the calibration is parsed out of the user text on first use
+    // (sif_ensure_calibration), most readers never ask for it
+    PRINT_VERBOSE("  User text: %d bytes, calibration parsed on demand\n", info->user_text_length);
 
     PRINT_VERBOSE("✓ SIF file parsing successfully");
 
     return 0;
 }
 
+// read only as much of the header as needed to locate the frame data:
+// user text, subimage table and timestamps are stepped over, not parsed,
+// and no frame storage is set up. Meant for listing many files quickly.
+int sif_probe(const char *path, SifProbe *probe) {
+    if (!path || !probe) return -1;
+    memset(probe, 0, sizeof(SifProbe));
+
+    FILE *fp = fopen(path, "rb");
+    if (!fp) return -1;
+
+    SifFile sif_file;
+    memset(&sif_file, 0, sizeof(SifFile));
+    sif_file.file_ptr = fp;
+    sif_file.info.raman_ex_wavelength = NAN;
+
+    SifReader reader;
+    if (reader_init_file(&reader, &sif_file, fp, SIF_PROBE_CHUNK) != 0) {
+        sif_decoder_close(sif_file.decoder);
+        fclose(fp);
+        return -1;
+    }
 
-void extract_frame_calibrations(SifInfo *info, int start_pos) {
-    if (!info || !info->user_text || start_pos < 0 || start_pos >= info->user_text_length) {
-        return;
+    int result = parse_header(&reader, &sif_file, 1, 0);
+    reader_free(&reader);
+    sif_decoder_close(sif_file.decoder);
+    fclose(fp);
+
+    if (result == 0) {
+        const SifInfo *info = &sif_file.info;
+        probe->sif_version = info->sif_version;
+        probe->number_of_frames = info->number_of_frames;
+        probe->number_of_subimages = info->number_of_subimages;
+        probe->image_width = info->image_width;
+        probe->image_height = info->image_height;
+        probe->pixels_per_frame = info->pixels_per_frame;
+        probe->exposure_time = info->exposure_time;
+        probe->detector_temperature = info->detector_temperature;
+        probe->data_offset = info->data_offset;
+        snprintf(probe->detector_type, sizeof(probe->detector_type), "%s",
+                 info->detector_type ? info->detector_type : "");
+    }
+
+    cleanup_sif_info(&sif_file.info);
+    return result;
+}
+
+// parse the header like sif_open, then map the whole file read-only so that
+// frames can be accessed in place without copying them to the heap
+int sif_open_mmap(FILE *fp, SifFile *sif_file) {
+    if (sif_open(fp, sif_file) != 0) {
+        return -1;
     }
-    
-    PRINT_VERBOSE("→ Extracting frame calibration data from position %d\n", start_pos);
-    
-    // copy user_text to a mutable buffer
-    char* text_copy = malloc(info->user_text_length + 1);
-    if (!text_copy) {
-        printf("  Memory allocation failed\n");
-        return;
+
+    // the file on disk is not the decompressed image
+    if (sif_file->decoder) {
+        PRINT_VERBOSE("  Compressed file, frames will be decoded instead of mapped\n");
+        return 0;
     }
-    memcpy(text_copy, info->user_text, info->user_text_length);
-    text_copy[info->user_text_length] = '\0';
-    
-    char* current_pos = text_copy + start_pos;
-    
-    // retrieving data for each frame
-    for (int frame = 1; frame <= info->number_of_frames; frame++) {
-        // construct the key char "Calibration data for frame X"
-        char target[64];
-        snprintf(target, sizeof(target), "Calibration data for frame %d", frame);
-        
-        // search for this target
-        char* frame_start = strstr(current_pos, target);
-        if (!frame_start) {
-            printf("  ✗ Calibration data for frame %d not found\n", frame);
+
+    struct stat st;
+    if (fstat(fileno(fp), &st) != 0 || st.st_size <= 0) {
+        PRINT_VERBOSE("  ⚠️ Cannot stat file, falling back to buffered reads\n");
+        return 0;
+    }
+
+    void *base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fileno(fp), 0);
+    if (base == MAP_FAILED) {
+        PRINT_VERBOSE("  ⚠️ mmap failed, falling back to buffered reads\n");
+        return 0;
+    }
+
+    sif_file->map_base = base;
+    sif_file->map_length = (size_t)st.st_size;
+    PRINT_VERBOSE("✓ Mapped %zu bytes\n", sif_file->map_length);
+
+    if (map_frame_data(sif_file) == 0) {
+        PRINT_VERBOSE("✓ Frame data accessible in place at offset 0x%lX\n", sif_file->info.data_offset);
+    } else {
+        PRINT_VERBOSE("  Frame data not usable in place, frames will be copied from the mapping\n");
+    }
+
+    return 0;
+}
+
+// point frame_data straight into the mapping. This needs native byte order,
+// a float-aligned data offset and the whole data section present in the file.
+static int map_frame_data(SifFile *sif_file) {
+    if (!sif_file->map_base || sif_file->frame_count == 0) {
+        return -1;
+    }
+
+    int64_t data_offset = sif_frame_offset(sif_file, 0);
+    if (((uintptr_t)sif_file->map_base + (uintptr_t)data_offset) % sizeof(float) != 0) {
+        return -1;
+    }
+
+    int64_t frame_bytes = (int64_t)sif_file->info.pixels_per_frame * sizeof(float);
+    int64_t data_end = data_offset + frame_bytes * sif_file->frame_count;
+    if (data_end > (int64_t)sif_file->map_length) {
+        return -1;
+    }
+
+    sif_file->frame_data = (float *)((unsigned char *)sif_file->map_base + data_offset);
+    sif_file->data_mapped = 1;
+    sif_file->data_loaded = 1;
+    sif_file->first_loaded_frame = 0;
+    sif_file->loaded_frame_count = sif_file->frame_count;
+    return 0;
+}
+
+// read pixels at a file offset, from the mapping if there is one. Reads are
+// positional and leave the FILE* cursor alone, so threads can share a handle.
+// The byte swap is fused in: mapped data is swapped on its way into dst, and
+// file reads go in SIF_SWAP_CHUNK_BYTES pieces, each swapped while it is still
+// in cache. Returns pixels read, or -1 with errno set when the read fails.
+static ssize_t read_pixels(const SifFile *sif_file, int64_t offset, float *dst, size_t pixel_count,
+                           int enable_byte_swap) {
+    if (sif_file->map_base) {
+        SIF_STATS_START(read_start);
+        if (offset < 0 || offset >= (int64_t)sif_file->map_length) {
+            return 0;
+        }
+
+        size_t available = (sif_file->map_length - (size_t)offset) / sizeof(float);
+        size_t count = pixel_count < available ? pixel_count : available;
+        const unsigned char *src = (const unsigned char *)sif_file->map_base + offset;
+        if (enable_byte_swap) {
+            swap_float_array_endian_copy(dst, src, count);
+            SIF_STATS_PHASE(sif_file->stats, SIF_PHASE_BYTE_SWAP, read_start, count * sizeof(float));
+        } else {
+            memcpy(dst, src, count * sizeof(float));
+            SIF_STATS_PHASE(sif_file->stats, SIF_PHASE_FRAME_READ, read_start, count * sizeof(float));
+        }
+        SIF_STATS_READ(sif_file->stats, count * sizeof(float), 0);
+        return (ssize_t)count;
+    }
+
+    size_t chunk = enable_byte_swap ? SIF_SWAP_CHUNK_BYTES / sizeof(float) : pixel_count;
+    size_t done = 0;
+
+    while (done < pixel_count) {
+        SIF_STATS_START(read_start);
+        size_t want = pixel_count - done < chunk ? pixel_count - done : chunk;
+        int64_t got = sif_read_at(sif_file, dst + done, want * sizeof(float), offset + (int64_t)(done * sizeof(float)));
+        if (got < 0) {
+            return -1;
+        }
+        SIF_STATS_READ(sif_file->stats, (uint64_t)got, 1);
+        SIF_STATS_PHASE(sif_file->stats, SIF_PHASE_FRAME_READ, read_start, (uint64_t)got);
+
+        size_t got_pixels = (size_t)got / sizeof(float);
+        if (enable_byte_swap) {
+            SIF_STATS_START(swap_start);
+            swap_float_array_endian(dst + done, got_pixels);
+            SIF_STATS_PHASE(sif_file->stats, SIF_PHASE_BYTE_SWAP, swap_start, got_pixels * sizeof(float));
+        }
+
+        done += got_pixels;
+        if (got_pixels < want) {
+            break;
+        }
+    }
+    return (ssize_t)done;
+}
+
+int64_t sif_read_at(const SifFile *sif_file, void *buffer, size_t count, int64_t offset) {
+    if (!sif_file || !buffer || offset < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (sif_file->decoder) {
+        return sif_decoder_pread(sif_file->decoder, buffer, count, offset);
+    }
+    if (!sif_file->file_ptr) {
+        errno = EBADF;
+        return -1;
+    }
+    return pread_full(fileno(sif_file->file_ptr), buffer, count, offset);
+}
+
+// file offset of a frame: frames (all subimages) sit back to back
+int64_t sif_frame_offset(const SifFile *sif_file, int frame_index) {
+    if (!sif_file) return -1;
+    return sif_file->info.data_offset +
+           (int64_t)frame_index * (int64_t)(sif_file->info.pixels_per_frame * sizeof(float));
+}
+
+
+void extract_frame_calibrations(SifInfo *info, int start_pos) {
+    if (!info || !info->user_text || start_pos < 0 || start_pos >= info->user_text_length) {
+        return;
+    }
+    
+    PRINT_VERBOSE("→ Extracting frame calibration data from position %d\n", start_pos);
+    
+    // copy user_text to a mutable buffer
+    char* text_copy = sif_mem_alloc(info->alloc, info->user_text_length + 1);
+    if (!text_copy) {
+        PRINT_SILENT("  Memory allocation failed\n");
+        return;
+    }
+    memcpy(text_copy, info->user_text, info->user_text_length);
+    text_copy[info->user_text_length] = '\0';
+    
+    char* current_pos = text_copy + start_pos;
+
+    // one entry per frame, sized from the header
+    if (!info->frame_calibrations && info->number_of_frames > 0) {
+        info->frame_calibrations = sif_mem_calloc(info->alloc, info->number_of_frames, sizeof(FrameCalibration));
+        if (!info->frame_calibrations) {
+            PRINT_SILENT("  Memory allocation failed\n");
+            sif_mem_free(info->alloc, text_copy);
+            return;
+        }
+    }
+    
+    // retrieving data for each frame
+    for (int frame = 1; frame <= info->number_of_frames; frame++) {
+        // construct the key char "Calibration data for frame X"
+        char target[64];
+        snprintf(target, sizeof(target), "Calibration data for frame %d", frame);
+        
+        // search for this target
+        char* frame_start = strstr(current_pos, target);
+        if (!frame_start) {
+            PRINT_VERBOSE("  ✗ Calibration data for frame %d not found\n", frame);
             continue;
         }
         
@@ -828,7 +1665,7 @@ void extract_frame_calibrations(SifInfo *info, int start_pos) {
         }
         
         if (!*data_start) {
-            printf("  ✗ No data after calibration marker for frame %d\n", frame);
+            PRINT_VERBOSE("  ✗ No data after calibration marker for frame %d\n", frame);
             continue;
         }
         
@@ -856,24 +1693,29 @@ void extract_frame_calibrations(SifInfo *info, int start_pos) {
         current_pos = data_end;
     }
     
-    free(text_copy);
+    sif_mem_free(info->alloc, text_copy);
     info->has_frame_calibrations = 1;
 }
 
 void parse_frame_calibration_coefficients(SifInfo *info, int frame, const char* data_str) {
     if (!info || !data_str) {
-        printf("    Error: Invalid parameters for frame %d\n", frame);
+        PRINT_SILENT("    Error: Invalid parameters for frame %d\n", frame);
         return;
     }
     
     PRINT_VERBOSE("    Parsing coefficients for frame %d: '%s'\n", frame, data_str);
     
-    // copy string for modification (strtok will modify the original string)
-    char* data_copy = strdup(data_str);
+    // copy string for modification (strtok will modify the original string);
+    // the usual short line is copied to the stack, one per frame adds up
+    char stack_copy[256];
+    size_t data_length = strlen(data_str);
+    char* data_copy = data_length < sizeof(stack_copy) ? stack_copy
+                                                       : sif_mem_alloc(info->alloc, data_length + 1);
     if (!data_copy) {
         PRINT_VERBOSE("    Memory allocation failed for frame %d\n", frame);
         return;
     }
+    memcpy(data_copy, data_str, data_length + 1);
     
     char* token;
     char* rest = data_copy;
@@ -907,7 +1749,7 @@ void parse_frame_calibration_coefficients(SifInfo *info, int frame, const char*
                     coefficients[coeff_count++] = value;
                     PRINT_VERBOSE("      Coefficient %d: %f\n", coeff_count, value);
                 } else {
-                    printf("      Warning: Failed to parse '%s' as float\n", token_trim);
+                    PRINT_VERBOSE("      Warning: Failed to parse '%s' as float\n", token_trim);
                 }
             }
         }
@@ -916,32 +1758,98 @@ void parse_frame_calibration_coefficients(SifInfo *info, int frame, const char*
     // save coefficients 
     if (coeff_count > 0) {
         // 確保不會超出陣列範圍
-        if (frame <= MAX_FRAMES) {
+        if (info->frame_calibrations && frame >= 1 && frame <= info->number_of_frames) {
             info->frame_calibrations[frame-1].coeff_count = coeff_count;
             memcpy(info->frame_calibrations[frame-1].coefficients, coefficients, 
                    coeff_count * sizeof(double));
             PRINT_VERBOSE("    ✓ Frame %d: %d coefficients parsed and saved\n", frame, coeff_count);
         } else {
-            PRINT_VERBOSE("    ✗ Frame %d: frame number exceeds maximum (%d)\n", frame, MAX_FRAMES);
+            PRINT_VERBOSE("    ✗ Frame %d: frame number out of range (%d frames)\n", frame, info->number_of_frames);
         }
     } else {
         PRINT_VERBOSE("    ✗ Frame %d: no valid coefficients found\n", frame);
     }
     
-    free(data_copy);
+    if (data_copy != stack_copy) {
+        sif_mem_free(info->alloc, data_copy);
+    }
+}
+
+
+// the user text noted at open (SifFile.user_text_offset), NUL-terminated
+static char *read_user_text(const SifFile *sif_file) {
+    const SifInfo *info = &sif_file->info;
+    size_t length = (size_t)info->user_text_length;
+
+    char *text = sif_mem_alloc(info->alloc, length + 1);
+    if (!text) return NULL;
+    SIF_STATS_ALLOC(sif_file->stats, length + 1);
+
+    if (sif_file->map_base && sif_file->user_text_offset + (int64_t)length <= (int64_t)sif_file->map_length) {
+        memcpy(text, (const char *)sif_file->map_base + sif_file->user_text_offset, length);
+    } else if (sif_read_at(sif_file, text, length, sif_file->user_text_offset) == (int64_t)length) {
+        SIF_STATS_READ(sif_file->stats, length, 1);
+    } else {
+        PRINT_SILENT("⚠️ Cannot read back the user text for the calibration\n");
+        sif_mem_free(info->alloc, text);
+        return NULL;
+    }
+
+    text[length] = '\0';
+    return text;
+}
+
+// parse the calibration out of the user text the first time it is needed.
+// The result is a cache on the handle, so const accessors may fill it.
+void sif_ensure_calibration(const SifInfo *info) {
+    if (!info || __atomic_load_n(&info->calibration_parsed, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+
+    // the first caller on this handle parses, later ones sleep on the
+    // handle's lock until it is done; other handles parse their own
+    // calibration meanwhile
+    SifInfo *mutable_info = (SifInfo *)info;
+    pthread_mutex_lock(&mutable_info->calibration_lock);
+    if (__atomic_load_n(&info->calibration_parsed, __ATOMIC_ACQUIRE)) {
+        pthread_mutex_unlock(&mutable_info->calibration_lock);
+        return;
+    }
+
+    SIF_STATS_START(calibration_start);
+    const SifLogSink *previous_log = sif_log_enter(mutable_info);
+    // a SifInfo only lives inside its SifFile
+    const SifFile *sif_file = (const SifFile *)((const char *)info - offsetof(SifFile, info));
+    if (!info->user_text && info->user_text_length > 0 && sif_file->user_text_offset > 0) {
+        mutable_info->user_text = read_user_text(sif_file);
+    }
+    extract_user_text(mutable_info);
+    sif_log_leave(previous_log);
+    SIF_STATS_PHASE(info->stats, SIF_PHASE_CALIBRATION, calibration_start, (uint64_t)info->user_text_length);
+
+    if (!mutable_info->user_text_kept) {
+        sif_mem_free(mutable_info->alloc, mutable_info->user_text);
+        mutable_info->user_text = NULL;
+    }
+    __atomic_store_n(&mutable_info->calibration_parsed, 1, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&mutable_info->calibration_lock);
 }
 
 int extract_calibration(const SifInfo *info, double **calibration, 
                        int *calib_width, int *calib_frames) {
     if (!info || !calibration) return -1;
+    sif_ensure_calibration(info);
     
-    int width = info->image_length > 0 ? info->image_length : info->detector_width;
+    int64_t length = info->image_length > 0 ? info->image_length : info->detector_width;
+    if (length <= 0 || length > INT_MAX) return -1;
+    int width = (int)length;
     
     if (info->has_frame_calibrations && info->number_of_frames > 0) {
         // Multiple calibrations (simplified)
+        if ((size_t)width > SIZE_MAX / sizeof(double) / (size_t)info->number_of_frames) return -1;
         *calib_frames = info->number_of_frames;
         *calib_width = width;
-        *calibration = malloc(*calib_frames * *calib_width * sizeof(double));
+        *calibration = sif_mem_alloc(NULL, (size_t)*calib_frames * (size_t)width * sizeof(double));
         
         if (!*calibration) return -1;
         
@@ -949,7 +1857,7 @@ int extract_calibration(const SifInfo *info, double **calibration,
         for (int f = 0; f < *calib_frames; f++) {
             for (int i = 0; i < width; i++) {
                 // Simplified linear calibration
-                (*calibration)[f * width + i] = i;
+                (*calibration)[(size_t)f * width + i] = i;
             }
         }
         
@@ -957,7 +1865,7 @@ int extract_calibration(const SifInfo *info, double **calibration,
         // Single calibration
         *calib_frames = 1;
         *calib_width = width;
-        *calibration = malloc(width * sizeof(double));
+        *calibration = sif_mem_alloc(NULL, (size_t)width * sizeof(double));
         
         if (!*calibration) return -1;
         
@@ -968,7 +1876,7 @@ int extract_calibration(const SifInfo *info, double **calibration,
             double x_power = 1;
             
             for (int j = 0; j < info->calibration_coeff_count; j++) {
-                value += info->calibration_data[j] * x_power;
+                value += info->calibration_coefficients[j] * x_power;
                 x_power *= x;
             }
             
@@ -986,14 +1894,14 @@ int extract_calibration(const SifInfo *info, double **calibration,
 }
 
 void parse_calibration_coefficients(SifInfo *info) {
-    if (!info || info->calibration_data[0] == '\0') {
+    if (!info || !info->calibration_data || info->calibration_data[0] == '\0') {
         info->calibration_coeff_count = 0;  // marked as 
         return;
     }
     
     PRINT_VERBOSE("→ Parsing calibration coefficients from: '%s'\n", info->calibration_data);
     
-    char* data_copy = strdup(info->calibration_data);
+    char* data_copy = sif_mem_strdup(info->alloc, info->calibration_data);
     if (!data_copy) {
         info->calibration_coeff_count = 0;
         return;
@@ -1024,14 +1932,14 @@ void parse_calibration_coefficients(SifInfo *info) {
                 PRINT_VERBOSE("    Coefficient %d: %f\n", coeff_count, value);
             } else {
                 PRINT_VERBOSE("    Failed to parse '%s' as float\n", token);
-                free(data_copy);
+                sif_mem_free(info->alloc, data_copy);
                 info->calibration_coeff_count = 0;
                 return;
             }
         }
     }
     
-    free(data_copy);
+    sif_mem_free(info->alloc, data_copy);
     
     if (coeff_count > 0) {
         // save coefficients
@@ -1045,29 +1953,32 @@ void parse_calibration_coefficients(SifInfo *info) {
 
 void extract_user_text(SifInfo *info) {
     if (!info || !info->user_text || info->user_text_length == 0) {
-        printf("  Skip: no user text to process\n");
+        PRINT_VERBOSE("  Skip: no user text to process\n");
         return;
     }
     
     PRINT_VERBOSE("→ extract_user_text analysis:\n");
     PRINT_VERBOSE("  user_text_length: %d\n", info->user_text_length);
-    PRINT_VERBOSE("  calibration_data: '%s'\n", info->calibration_data);
+    PRINT_VERBOSE("  calibration_data: '%s'\n", info->calibration_data ? info->calibration_data : "");
     
     // search for "Calibration data for" - in the first 20 bytes of user_text
     const char* target = "Calibration data for";
     int found = 0;
     
     int search_limit = (info->user_text_length < 20) ? info->user_text_length : 20;
+    int target_length = (int)strlen(target);
     
-    for (int i = 0; i <= search_limit - strlen(target); i++) {
-        if (strncmp(&info->user_text[i], target, strlen(target)) == 0) {
+    // signed bound: a user text shorter than the target must not wrap around
+    for (int i = 0; i + target_length <= search_limit; i++) {
+        if (strncmp(&info->user_text[i], target, target_length) == 0) {
             PRINT_VERBOSE("  ✓ Found '%s' in first %d bytes of user_text at position %d\n", 
                    target, search_limit, i);
             found = 1;
             
             extract_frame_calibrations(info, i);
             
-            info->calibration_data[0] = '\0';
+            sif_mem_free(info->alloc, info->calibration_data);
+            info->calibration_data = NULL;
             info->calibration_coeff_count = 0;
             
             break;
@@ -1078,7 +1989,7 @@ void extract_user_text(SifInfo *info) {
         PRINT_VERBOSE("  ✗ '%s' not found in first %d bytes of user_text\n", target, search_limit);
         
         // processing the present calibration_data
-        if (info->calibration_data[0] != '\0') {
+        if (info->calibration_data && info->calibration_data[0] != '\0') {
             PRINT_VERBOSE("  calibration_data is a string: '%s'\n", info->calibration_data);
             
             // 嘗試解析校準係數
@@ -1091,7 +2002,8 @@ void extract_user_text(SifInfo *info) {
             } else {
                 // fails to parse
                 PRINT_VERBOSE("  ✗ Failed to parse calibration coefficients, clearing data\n");
-                info->calibration_data[0] = '\0';
+                sif_mem_free(info->alloc, info->calibration_data);
+                info->calibration_data = NULL;
                 info->calibration_coeff_count = 0;
             }
         } else {
@@ -1104,241 +2016,1008 @@ void extract_user_text(SifInfo *info) {
     PRINT_VERBOSE("✓ User text processing completed\n");
 }
 
-// bytes swap
-static void swap_float_array_endian(float *data, int count) {
-    for (int i = 0; i < count; i++) {
-        uint32_t temp;
-        memcpy(&temp, &data[i], sizeof(uint32_t));
-        temp = ((temp & 0xFF) << 24) | ((temp & 0xFF00) << 8) |
-               ((temp & 0xFF0000) >> 8) | ((temp & 0xFF000000) >> 24);
-        memcpy(&data[i], &temp, sizeof(float));
-    }
-}
-
 // main frame-data loading 
 int sif_load_all_frames(SifFile *sif_file, int enable_byte_swap) {
-    if (!sif_file || !sif_file->file_ptr || sif_file->frame_count == 0) {
+    if (!sif_file) return -1;
+
+    const SifLogSink *previous_log = sif_log_enter(&sif_file->info);
+    int result = load_all_frames(sif_file, enable_byte_swap);
+    sif_log_leave(previous_log);
+    return result;
+}
+
+static int load_all_frames(SifFile *sif_file, int enable_byte_swap) {
+    if (!sif_file || (!sif_file->file_ptr && !sif_file->map_base) || sif_file->frame_count == 0) {
         return -1;
     }
     
+    // mapped frames in native byte order are already accessible
+    if (sif_file->data_mapped && !enable_byte_swap) {
+        return 0;
+    }
+
     if (sif_file->data_loaded) {
         sif_unload_data(sif_file);
     }
+
+    if (!enable_byte_swap && map_frame_data(sif_file) == 0) {
+        PRINT_VERBOSE("✓ Using %d mapped frames in place\n", sif_file->frame_count);
+        return 0;
+    }
     
-    int frame_size = sif_file->tiles[0].width * sif_file->tiles[0].height;
-    int total_pixels = sif_file->frame_count * frame_size;
+    size_t frame_size = sif_file->info.pixels_per_frame;
+    size_t total_pixels = (size_t)sif_file->frame_count * frame_size;
     
     PRINT_VERBOSE("→ Loading frame data%s:\n", enable_byte_swap ? " with endian correction" : "");
-    PRINT_VERBOSE("  Frame size: %d x %d = %d pixels\n", 
-           sif_file->tiles[0].width, sif_file->tiles[0].height, frame_size);
+    PRINT_VERBOSE("  Frame size: %zu pixels (%d track(s), first %d x %d)\n", frame_size,
+           sif_file->info.number_of_subimages, sif_file->info.image_width, sif_file->info.image_height);
     PRINT_VERBOSE("  Byte swap: %s\n", enable_byte_swap ? "ENABLED" : "DISABLED");
     
     // allocate memory
-    sif_file->frame_data = malloc(total_pixels * sizeof(float));
+    sif_file->frame_data = take_buffer(sif_file, &sif_file->spare_frames, total_pixels * sizeof(float));
     if (!sif_file->frame_data) {
-        printf("❌ Failed to allocate memory\n");
+        PRINT_SILENT("❌ Failed to allocate memory\n");
         return -1;
     }
     
-    FILE *fp = sif_file->file_ptr;
+    // every track of every frame, back to back: one read for all of it,
+    // with the byte swap done chunk by chunk inside the read
+    ssize_t got = read_pixels(sif_file, sif_frame_offset(sif_file, 0), sif_file->frame_data, total_pixels,
+                              enable_byte_swap);
+    size_t read_count = got < 0 ? 0 : (size_t)got;
+    if (read_count != total_pixels) {
+        PRINT_SILENT("⚠️ Only read %zu/%zu pixels\n", read_count, total_pixels);
+        memset(sif_file->frame_data + read_count, 0, (total_pixels - read_count) * sizeof(float));
+    }
     
-    // direct retrieve all data
-    for (int i = 0; i < sif_file->frame_count; i++) {
-        long offset = sif_file->tiles[i].offset;
-        fseek(fp, offset, SEEK_SET);
-        
-        float *frame_start = sif_file->frame_data + i * frame_size;
-        size_t read_count = fread(frame_start, sizeof(float), frame_size, fp);
-        
-        if (read_count != frame_size) {
-            printf("⚠️ Frame %d: Only read %zu/%d pixels\n", i, read_count, frame_size);
-        }
+    // debug the first frame
+    if (SIF_LOG_ENABLED(SIF_VERBOSE)) {
+        float *frame_start = sif_file->frame_data;
+
+        PRINT_VERBOSE("  Frame 0%s:\n", enable_byte_swap ? " after byte swap" : " (raw)");
         
-        // bytes swapping 
-        if (enable_byte_swap) {
-            swap_float_array_endian(frame_start, frame_size);
+        // original file bytes, recovered from the loaded values (no extra read)
+        PRINT_VERBOSE("    Original bytes -> Values:\n");
+        for (size_t j = 0; j < 10 && j < frame_size; j++) {
+            unsigned char raw_bytes[4];
+            memcpy(raw_bytes, &frame_start[j], 4);
+            if (enable_byte_swap) {
+                unsigned char t = raw_bytes[0]; raw_bytes[0] = raw_bytes[3]; raw_bytes[3] = t;
+                t = raw_bytes[1]; raw_bytes[1] = raw_bytes[2]; raw_bytes[2] = t;
+            }
+            PRINT_VERBOSE("    Pixel %zu: %02X %02X %02X %02X -> %.1f\n",
+                   j, raw_bytes[0], raw_bytes[1], 
+                   raw_bytes[2], raw_bytes[3], frame_start[j]);
         }
         
-        // debug the first frame
-        if (i == 0) {
-            PRINT_VERBOSE("  Frame 0%s:\n", enable_byte_swap ? " after byte swap" : " (raw)");
-            
-            // re-read original bytes to compare
-            fseek(fp, offset, SEEK_SET);
-            unsigned char raw_bytes[40];
-            fread(raw_bytes, 1, 40, fp);
-            
-            PRINT_VERBOSE("    Original bytes -> Values:\n");
-            for (int j = 0; j < 10 && j < frame_size; j++) {
-                PRINT_VERBOSE("    Pixel %d: %02X %02X %02X %02X -> %.1f\n",
-                       j, raw_bytes[j*4], raw_bytes[j*4+1], 
-                       raw_bytes[j*4+2], raw_bytes[j*4+3], frame_start[j]);
-            }
-            
-            // validify values, which dependes on CCD model type
-            int valid_count = 0;
-            for (int j = 0; j < frame_size; j++) {
-                // note: this value based upon CCD camera
-                if (frame_start[j] > 600.0f) {
-                    valid_count++;
-                    if (valid_count <= 3) {
-                        PRINT_VERBOSE("    Valid value at pixel %d: %.1f\n", j, frame_start[j]);
-                    }
+        // validify values, which dependes on CCD model type
+        size_t valid_count = 0;
+        for (size_t j = 0; j < frame_size; j++) {
+            // note: this value based upon CCD camera
+            if (frame_start[j] > 600.0f) {
+                valid_count++;
+                if (valid_count <= 3) {
+                    PRINT_VERBOSE("    Valid value at pixel %zu: %.1f\n", j, frame_start[j]);
                 }
             }
-            
-            PRINT_VERBOSE("    Total valid values (>600 range): %d/%d\n", valid_count, frame_size);
         }
+        
+        PRINT_VERBOSE("    Total valid values (>600 range): %zu/%zu\n", valid_count, frame_size);
     }
     
     sif_file->data_loaded = 1;
+    sif_file->first_loaded_frame = 0;
+    sif_file->loaded_frame_count = sif_file->frame_count;
     PRINT_VERBOSE("✓ Loaded %d frames%s\n", sif_file->frame_count, 
            enable_byte_swap ? " with endian correction" : "");
     return 0;
 }
    
 int sif_load_single_frame(SifFile *sif_file, int frame_index) {
-    if (!sif_file || !sif_file->file_ptr || sif_file->frame_count == 0) {
+    if (!sif_file) return -1;
+
+    const SifLogSink *previous_log = sif_log_enter(&sif_file->info);
+    int result = load_single_frame(sif_file, frame_index);
+    sif_log_leave(previous_log);
+    return result;
+}
+
+static int load_single_frame(SifFile *sif_file, int frame_index) {
+    if (!sif_file || (!sif_file->file_ptr && !sif_file->map_base) || sif_file->frame_count == 0) {
         return -1;
     }
     
     if (frame_index < 0 || frame_index >= sif_file->frame_count) {
-        printf("❌ Frame index %d out of range (0-%d)\n", 
+        PRINT_SILENT("❌ Frame index %d out of range (0-%d)\n", 
                frame_index, sif_file->frame_count - 1);
         return -1;
     }
     
-    // unload first if loaded
+    PRINT_VERBOSE("→ Loading single frame %d:\n", frame_index);
+    
+    return sif_load_frame_range(sif_file, frame_index, frame_index + 1);
+}
+
+// load frames [start_frame, end_frame) with one contiguous read. Frames
+// sit back to back from data_offset, so the whole window is a single span.
+int sif_load_frame_range(SifFile *sif_file, int start_frame, int end_frame) {
+    if (!sif_file) return -1;
+
+    const SifLogSink *previous_log = sif_log_enter(&sif_file->info);
+    int result = load_frame_range(sif_file, start_frame, end_frame);
+    sif_log_leave(previous_log);
+    return result;
+}
+
+static int load_frame_range(SifFile *sif_file, int start_frame, int end_frame) {
+    if (!sif_file || (!sif_file->file_ptr && !sif_file->map_base) || sif_file->frame_count == 0) {
+        return -1;
+    }
+
+    if (start_frame < 0 || end_frame > sif_file->frame_count || start_frame >= end_frame) {
+        PRINT_SILENT("❌ Frame range [%d, %d) out of range (0-%d)\n",
+               start_frame, end_frame, sif_file->frame_count);
+        return -1;
+    }
+
+    // every frame is already reachable through the mapping
+    if (sif_file->data_mapped) {
+        return 0;
+    }
+
+    int frame_count = end_frame - start_frame;
+    size_t frame_size = sif_file->info.pixels_per_frame;
+    size_t span = (size_t)frame_count * frame_size;
+
+    PRINT_VERBOSE("→ Loading frames %d-%d (%d frames):\n", start_frame, end_frame - 1, frame_count);
+    PRINT_VERBOSE("  Frame size: %zu pixels (%d track(s))\n", frame_size, sif_file->info.number_of_subimages);
+
+    float *data = take_buffer(sif_file, &sif_file->spare_frames, span * sizeof(float));
+    if (!data) {
+        PRINT_SILENT("❌ Failed to allocate memory for %d frames\n", frame_count);
+        return -1;
+    }
+
+    // the current window stays loaded until the new one has been read, a
+    // failed read leaves the handle as it was
+    ssize_t got = read_pixels(sif_file, sif_frame_offset(sif_file, start_frame), data, span, 0);
+    if (got < 0) {
+        PRINT_SILENT("❌ Frames %d-%d: Read failed: %s\n", start_frame, end_frame - 1, strerror(errno));
+        sif_mem_free(sif_file->info.alloc, data);
+        return -1;
+    }
+    size_t read_count = (size_t)got;
+    if (read_count != span) {
+        // the file ends early: like a full load, the missing pixels read as 0
+        PRINT_SILENT("⚠️ Frames %d-%d: Only read %zu/%zu pixels\n",
+               start_frame, end_frame - 1, read_count, span);
+        memset(data + read_count, 0, (span - read_count) * sizeof(float));
+    }
+
     if (sif_file->data_loaded) {
         sif_unload_data(sif_file);
     }
-    
-    int frame_size = sif_file->tiles[0].width * sif_file->tiles[0].height;
-    int total_pixels = frame_size;  // load only the first frame
-    
-    PRINT_VERBOSE("→ Loading single frame %d:\n", frame_index);
-    PRINT_VERBOSE("  Frame size: %d x %d = %d pixels\n", 
-           sif_file->tiles[0].width, sif_file->tiles[0].height, frame_size);
-    
-    // allocate memory
-    sif_file->frame_data = malloc(total_pixels * sizeof(float));
+    sif_file->frame_data = data;
+    sif_file->data_loaded = 1;
+    sif_file->first_loaded_frame = start_frame;
+    sif_file->loaded_frame_count = frame_count;
+
+    PRINT_VERBOSE("✓ Loaded frames %d-%d (%zu pixels)\n", start_frame, end_frame - 1, span);
+    return 0;
+}
+
+// read frames [start_frame, end_frame) into their slice of frame_data,
+// block by block; read_pixels swaps each chunk while it is still in cache
+static void *frame_load_worker(void *arg) {
+    FrameLoadTask *task = (FrameLoadTask *)arg;
+    SifFile *sif_file = task->sif_file;
+
+    size_t frame_size = sif_file->info.pixels_per_frame;
+
+    // frames are contiguous, several of them go into each read
+    size_t frame_bytes = frame_size * sizeof(float);
+    int frames_per_block = frame_bytes >= SIF_LOAD_BLOCK_BYTES ? 1 : (int)(SIF_LOAD_BLOCK_BYTES / frame_bytes);
+
+    for (int f = task->start_frame; f < task->end_frame; f += frames_per_block) {
+        int block_frames = task->end_frame - f < frames_per_block ? task->end_frame - f : frames_per_block;
+        size_t block_pixels = (size_t)block_frames * frame_size;
+        float *dst = sif_file->frame_data + (size_t)f * frame_size;
+        int64_t offset = sif_frame_offset(sif_file, f);
+
+        ssize_t got = read_pixels(sif_file, offset, dst, block_pixels, task->enable_byte_swap);
+        if (got < 0) {
+            task->error = errno;
+            return NULL;
+        }
+
+        if ((size_t)got < block_pixels) {
+            // the file ends early: no stale data in the rest of the block
+            memset(dst + got, 0, (block_pixels - (size_t)got) * sizeof(float));
+            task->missing_pixels += block_pixels - (size_t)got;
+        }
+    }
+
+    return NULL;
+}
+
+// sif_load_all_frames split over num_threads workers (<= 0 means one per CPU)
+int sif_load_all_frames_parallel(SifFile *sif_file, int enable_byte_swap, int num_threads) {
+    if (!sif_file) return -1;
+
+    const SifLogSink *previous_log = sif_log_enter(&sif_file->info);
+    int result = load_all_frames_parallel(sif_file, enable_byte_swap, num_threads);
+    sif_log_leave(previous_log);
+    return result;
+}
+
+static int load_all_frames_parallel(SifFile *sif_file, int enable_byte_swap, int num_threads) {
+    if (!sif_file || (!sif_file->file_ptr && !sif_file->map_base) || sif_file->frame_count == 0) {
+        return -1;
+    }
+
+    // mapped frames in native byte order are already accessible
+    if (sif_file->data_mapped && !enable_byte_swap) {
+        return 0;
+    }
+
+    if (sif_file->data_loaded) {
+        sif_unload_data(sif_file);
+    }
+
+    if (!enable_byte_swap && map_frame_data(sif_file) == 0) {
+        PRINT_VERBOSE("✓ Using %d mapped frames in place\n", sif_file->frame_count);
+        return 0;
+    }
+
+    if (num_threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        num_threads = cpus > 0 ? (int)cpus : 1;
+    }
+    if (num_threads > SIF_MAX_LOAD_THREADS) num_threads = SIF_MAX_LOAD_THREADS;
+    if (num_threads > sif_file->frame_count) num_threads = sif_file->frame_count;
+    // a decompressor has one decoding position: split reads would only
+    // queue on it, and send a stream back to its start
+    if (sif_file->decoder) num_threads = 1;
+
+    size_t frame_size = sif_file->info.pixels_per_frame;
+    size_t total_pixels = (size_t)sif_file->frame_count * frame_size;
+
+    PRINT_VERBOSE("→ Loading frame data with %d thread(s)%s:\n", num_threads,
+           enable_byte_swap ? " with endian correction" : "");
+    PRINT_VERBOSE("  Frame size: %zu pixels (%d track(s))\n", frame_size, sif_file->info.number_of_subimages);
+
+    sif_file->frame_data = take_buffer(sif_file, &sif_file->spare_frames, total_pixels * sizeof(float));
     if (!sif_file->frame_data) {
-        printf("❌ Failed to allocate memory for frame %d\n", frame_index);
+        PRINT_SILENT("❌ Failed to allocate memory\n");
         return -1;
     }
-    
-    FILE *fp = sif_file->file_ptr;
-    
-    // read definite frames
-    long offset = sif_file->tiles[frame_index].offset;
-    fseek(fp, offset, SEEK_SET);
-    
-    size_t read_count = fread(sif_file->frame_data, sizeof(float), frame_size, fp);
-    
-    if (read_count != frame_size) {
-        printf("⚠️ Frame %d: Only read %zu/%d pixels\n", frame_index, read_count, frame_size);
-        free(sif_file->frame_data);
+
+    FrameLoadTask tasks[SIF_MAX_LOAD_THREADS];
+    pthread_t threads[SIF_MAX_LOAD_THREADS];
+    int started[SIF_MAX_LOAD_THREADS];
+
+    int frames_per_thread = sif_file->frame_count / num_threads;
+    int extra_frames = sif_file->frame_count % num_threads;
+    int next_frame = 0;
+
+    for (int t = 0; t < num_threads; t++) {
+        int count = frames_per_thread + (t < extra_frames ? 1 : 0);
+
+        tasks[t].sif_file = sif_file;
+        tasks[t].start_frame = next_frame;
+        tasks[t].end_frame = next_frame + count;
+        tasks[t].enable_byte_swap = enable_byte_swap;
+        tasks[t].error = 0;
+        tasks[t].missing_pixels = 0;
+        next_frame += count;
+
+        // the last chunk runs on the calling thread
+        started[t] = 0;
+        if (t < num_threads - 1 && pthread_create(&threads[t], NULL, frame_load_worker, &tasks[t]) == 0) {
+            started[t] = 1;
+        }
+    }
+
+    for (int t = 0; t < num_threads; t++) {
+        if (!started[t]) frame_load_worker(&tasks[t]);
+    }
+
+    int error = 0;
+    size_t missing_pixels = 0;
+    for (int t = 0; t < num_threads; t++) {
+        if (started[t]) pthread_join(threads[t], NULL);
+        if (tasks[t].error != 0) error = tasks[t].error;
+        missing_pixels += tasks[t].missing_pixels;
+    }
+
+    if (error != 0) {
+        PRINT_SILENT("❌ Read error while loading frames: %s\n", strerror(error));
+        sif_unload_data(sif_file);
+        return -1;
+    }
+
+    if (missing_pixels > 0) {
+        PRINT_SILENT("⚠️ Only read %zu/%zu pixels\n", total_pixels - missing_pixels, total_pixels);
+    }
+
+    sif_file->data_loaded = 1;
+    sif_file->first_loaded_frame = 0;
+    sif_file->loaded_frame_count = sif_file->frame_count;
+    PRINT_VERBOSE("✓ Loaded %d frames with %d thread(s)\n", sif_file->frame_count, num_threads);
+    return 0;
+}
+
+// sif_load_all_frames without going through the page cache: the data region
+// is read in large aligned blocks with O_DIRECT and trimmed into frame_data
+int sif_load_all_frames_direct(SifFile *sif_file, int enable_byte_swap) {
+    if (!sif_file) return -1;
+
+    const SifLogSink *previous_log = sif_log_enter(&sif_file->info);
+    int result = load_all_frames_direct(sif_file, enable_byte_swap);
+    sif_log_leave(previous_log);
+    return result;
+}
+
+static int load_all_frames_direct(SifFile *sif_file, int enable_byte_swap) {
+    if (!sif_file || !sif_file->file_ptr || sif_file->frame_count == 0) {
+        return -1;
+    }
+
+    // O_DIRECT would read the compressed bytes
+    if (sif_file->decoder) {
+        PRINT_VERBOSE("  Compressed file, using buffered loading\n");
+        return sif_load_all_frames(sif_file, enable_byte_swap);
+    }
+
+#ifndef O_DIRECT
+    PRINT_VERBOSE("  O_DIRECT not available, using buffered loading\n");
+    return sif_load_all_frames(sif_file, enable_byte_swap);
+#else
+    // reopen the same file with O_DIRECT, the FILE* stays untouched
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/self/fd/%d", fileno(sif_file->file_ptr));
+    int fd = open(path, O_RDONLY | O_DIRECT);
+    if (fd < 0 && sif_file->filename) {
+        fd = open(sif_file->filename, O_RDONLY | O_DIRECT);
+    }
+    if (fd < 0) {
+        PRINT_VERBOSE("  O_DIRECT open failed (%s), using buffered loading\n", strerror(errno));
+        return sif_load_all_frames(sif_file, enable_byte_swap);
+    }
+
+    if (sif_file->data_loaded) {
+        sif_unload_data(sif_file);
+    }
+
+    size_t frame_size = sif_file->info.pixels_per_frame;
+    size_t frame_bytes = frame_size * sizeof(float);
+    size_t total_pixels = (size_t)sif_file->frame_count * frame_size;
+
+    PRINT_VERBOSE("→ Loading frame data with O_DIRECT%s:\n", enable_byte_swap ? " with endian correction" : "");
+    PRINT_VERBOSE("  Frame size: %zu pixels (%d track(s))\n", frame_size, sif_file->info.number_of_subimages);
+
+    void *block = NULL;
+    sif_file->frame_data = take_buffer(sif_file, &sif_file->spare_frames, total_pixels * sizeof(float));
+    if (!sif_file->frame_data || posix_memalign(&block, SIF_DIRECT_ALIGN, SIF_DIRECT_BLOCK_BYTES) != 0) {
+        PRINT_SILENT("❌ Failed to allocate memory\n");
+        sif_mem_free(sif_file->info.alloc, sif_file->frame_data);
         sif_file->frame_data = NULL;
+        close(fd);
         return -1;
     }
-    
-    PRINT_VERBOSE("✓ Loaded frame %d (%d pixels)\n", frame_index, frame_size);
-    
+    SIF_STATS_ALLOC(sif_file->stats, SIF_DIRECT_BLOCK_BYTES);
+
+    int64_t data_end = sif_frame_offset(sif_file, sif_file->frame_count - 1) + (int64_t)frame_bytes;
+    int64_t pos = sif_frame_offset(sif_file, 0) & ~(int64_t)(SIF_DIRECT_ALIGN - 1);
+    int done_frames = 0;
+    int error = 0;
+
+    while (pos < data_end && done_frames < sif_file->frame_count) {
+        int64_t remaining = (data_end - pos + SIF_DIRECT_ALIGN - 1) & ~(int64_t)(SIF_DIRECT_ALIGN - 1);
+        size_t want = remaining < SIF_DIRECT_BLOCK_BYTES ? (size_t)remaining : SIF_DIRECT_BLOCK_BYTES;
+
+        SIF_STATS_START(read_start);
+        ssize_t got = pread_full(fd, block, want, pos);
+        if (got < 0) {
+            error = errno;
+            break;
+        }
+        SIF_STATS_READ(sif_file->stats, (uint64_t)got, 1);
+        SIF_STATS_PHASE(sif_file->stats, SIF_PHASE_FRAME_READ, read_start, (uint64_t)got);
+        int64_t block_end = pos + got;
+
+        // copy the part of every frame that falls inside [pos, block_end)
+        for (int f = done_frames; f < sif_file->frame_count; f++) {
+            int64_t frame_start = sif_frame_offset(sif_file, f);
+            int64_t frame_end = frame_start + (int64_t)frame_bytes;
+            if (frame_start >= block_end) break;
+
+            int64_t from = frame_start > pos ? frame_start : pos;
+            int64_t to = frame_end < block_end ? frame_end : block_end;
+            if (to > from) {
+                memcpy((unsigned char *)(sif_file->frame_data + (size_t)f * frame_size) + (from - frame_start),
+                       (unsigned char *)block + (from - pos), (size_t)(to - from));
+            }
+
+            // frame complete: swap it while it is still in cache
+            if (frame_end <= block_end) {
+                if (enable_byte_swap) {
+                    SIF_STATS_START(swap_start);
+                    swap_float_array_endian(sif_file->frame_data + (size_t)f * frame_size, frame_size);
+                    SIF_STATS_PHASE(sif_file->stats, SIF_PHASE_BYTE_SWAP, swap_start, frame_bytes);
+                }
+                done_frames = f + 1;
+            }
+        }
+
+        if ((size_t)got < want) break;  // end of file
+        pos = block_end;
+    }
+
+    free(block);
+    close(fd);
+
+    if (error == EINVAL && done_frames == 0) {
+        // the filesystem refuses direct I/O at this alignment
+        PRINT_VERBOSE("  O_DIRECT read rejected, using buffered loading\n");
+        sif_unload_data(sif_file);
+        return sif_load_all_frames(sif_file, enable_byte_swap);
+    }
+
+    if (error != 0) {
+        PRINT_SILENT("❌ Read error while loading frames: %s\n", strerror(error));
+        sif_unload_data(sif_file);
+        return -1;
+    }
+
+    if (done_frames < sif_file->frame_count) {
+        PRINT_SILENT("⚠️ Only read %d/%d frames\n", done_frames, sif_file->frame_count);
+        memset(sif_file->frame_data + (size_t)done_frames * frame_size, 0,
+               (size_t)(sif_file->frame_count - done_frames) * frame_bytes);
+    }
+
     sif_file->data_loaded = 1;
+    sif_file->first_loaded_frame = 0;
+    sif_file->loaded_frame_count = sif_file->frame_count;
+    PRINT_VERBOSE("✓ Loaded %d frames with O_DIRECT\n", sif_file->frame_count);
     return 0;
+#endif
 }
 
 float* sif_get_frame_data(SifFile *sif_file, int frame_index) {
-    if (!sif_file || !sif_file->frame_data || 
-        frame_index < 0 || frame_index >= sif_file->frame_count) {
+    if (!sif_file || frame_index < 0 || frame_index >= sif_file->frame_count) {
         return NULL;
     }
+
+    // frame_index is absolute, frame_data only holds the loaded window
+    int window_index = frame_index - sif_file->first_loaded_frame;
+    if (!sif_file->frame_data || window_index < 0 || window_index >= sif_file->loaded_frame_count) {
+        if (!sif_file->prefetcher) return NULL;
+
+        const SifLogSink *previous_log = sif_log_enter(&sif_file->info);
+        float *frame = sif_prefetch_get_frame(sif_file, frame_index);
+        sif_log_leave(previous_log);
+        return frame;
+    }
     
-    int frame_size = sif_file->tiles[0].width * sif_file->tiles[0].height;
-    return sif_file->frame_data + frame_index * frame_size;
+    return sif_file->frame_data + (size_t)window_index * sif_file->info.pixels_per_frame;
 }
 
 float sif_get_pixel_value(SifFile *sif_file, int frame_index, int row, int col) {
-    if (!sif_file || !sif_file->frame_data) {
+    if (!sif_file || (!sif_file->frame_data && !sif_file->prefetcher)) {
         return 0.0f;
     }
     
     if (frame_index < 0 || frame_index >= sif_file->frame_count ||
-        row < 0 || row >= sif_file->tiles[0].height ||
-        col < 0 || col >= sif_file->tiles[0].width) {
+        row < 0 || row >= sif_file->info.image_height ||
+        col < 0 || col >= sif_file->info.image_width) {
         return 0.0f;
     }
     
-    int frame_size = sif_file->tiles[0].width * sif_file->tiles[0].height;
-    int pixel_index = frame_index * frame_size + row * sif_file->tiles[0].width + col;
+    float *frame = sif_get_frame_data(sif_file, frame_index);
+    if (!frame) {
+        return 0.0f;
+    }
     
-    return sif_file->frame_data[pixel_index];
+    return frame[row * sif_file->info.image_width + col];
 }
 
-// copy frame data to buffer of the user
+// copy frame data (first track, width * height pixels) to buffer of the user
 int sif_copy_frame_data(SifFile *sif_file, int frame_index, float *output_buffer) {
-    if (!sif_file || !sif_file->frame_data || !output_buffer) {
+    if (!sif_file || !output_buffer) {
         return -1;
     }
     
     if (frame_index < 0 || frame_index >= sif_file->frame_count) {
         return -1;
     }
-    
-    int frame_size = sif_file->tiles[0].width * sif_file->tiles[0].height;
-    float *frame_start = sif_get_frame_data(sif_file, frame_index);
-    
-    memcpy(output_buffer, frame_start, frame_size * sizeof(float));
+
+    int frame_size = sif_file->info.image_width * sif_file->info.image_height;
+
+    int window_index = frame_index - sif_file->first_loaded_frame;
+    if (sif_file->frame_data && window_index >= 0 && window_index < sif_file->loaded_frame_count) {
+        memcpy(output_buffer, sif_file->frame_data + (size_t)window_index * sif_file->info.pixels_per_frame,
+               frame_size * sizeof(float));
+        return 0;
+    }
+
+    // frames outside the loaded window come from the cache when there is one
+    if (sif_file->cache) {
+        const float *frame_start = sif_cache_acquire(sif_file, frame_index);
+        if (!frame_start) {
+            return -1;
+        }
+        memcpy(output_buffer, frame_start, frame_size * sizeof(float));
+        sif_cache_release(sif_file, frame_index);
+        return 0;
+    }
+
+    // not loaded: the byte order a read should get is unknown here, callers
+    // that read from the file use sif_read_frames with an explicit swap flag
+    return -1;
+}
+
+// positional read of whole frames (all tracks) into a caller buffer. It does
+// not touch the handle, so any number of threads may call it on one handle.
+int sif_read_frames(const SifFile *sif_file, int start_frame, int frame_count,
+                    float *output_buffer, int enable_byte_swap) {
+    if (!sif_file || (!sif_file->file_ptr && !sif_file->map_base) || !output_buffer || frame_count <= 0) {
+        return -1;
+    }
+
+    if (start_frame < 0 || start_frame + frame_count > sif_file->frame_count) {
+        return -1;
+    }
+
+    size_t span = (size_t)frame_count * sif_file->info.pixels_per_frame;
+    ssize_t got = read_pixels(sif_file, sif_frame_offset(sif_file, start_frame), output_buffer, span,
+                              enable_byte_swap);
+    size_t read_count = got < 0 ? 0 : (size_t)got;
+    if (read_count != span) {
+        const SifLogSink *previous_log = sif_log_enter(&sif_file->info);
+        PRINT_SILENT("⚠️ Frames %d-%d: Only read %zu/%zu pixels\n",
+               start_frame, start_frame + frame_count - 1, read_count, span);
+        sif_log_leave(previous_log);
+        return -1;
+    }
+    return 0;
+}
+
+// decode the timestamp block noted by a lazy open. Concurrent first calls
+// each decode a copy and the first one published wins.
+const int64_t *sif_get_timestamps(SifFile *sif_file) {
+    if (!sif_file) return NULL;
+
+    int64_t *timestamps = __atomic_load_n(&sif_file->info.timestamps, __ATOMIC_ACQUIRE);
+    int count = sif_file->info.number_of_frames;
+    if (timestamps || count <= 0 || sif_file->timestamp_length == 0) {
+        return timestamps;
+    }
+
+    SIF_STATS_START(timestamps_start);
+    size_t length = sif_file->timestamp_length;
+    unsigned char *text = NULL;
+    const unsigned char *block;
+
+    if (sif_file->map_base && sif_file->timestamp_offset + (int64_t)length <= (int64_t)sif_file->map_length) {
+        block = (const unsigned char *)sif_file->map_base + sif_file->timestamp_offset;
+    } else {
+        text = sif_mem_alloc(sif_file->info.alloc, length);
+        if (!text || sif_read_at(sif_file, text, length, sif_file->timestamp_offset) != (int64_t)length) {
+            sif_mem_free(sif_file->info.alloc, text);
+            return NULL;
+        }
+        SIF_STATS_READ(sif_file->stats, length, 1);
+        block = text;
+    }
+
+    timestamps = sif_mem_alloc(sif_file->info.alloc, (size_t)count * sizeof(int64_t));
+    if (timestamps) {
+        SIF_STATS_ALLOC(sif_file->stats, (size_t)count * sizeof(int64_t));
+        int parsed = 0;
+        parse_timestamp_lines(block, length, timestamps, count, &parsed);
+        for (int f = parsed; f < count; f++) {
+            timestamps[f] = 0;
+        }
+    }
+    sif_mem_free(sif_file->info.alloc, text);
+    SIF_STATS_PHASE(sif_file->stats, SIF_PHASE_TIMESTAMPS, timestamps_start, length);
+
+    int64_t *expected = NULL;
+    if (timestamps && !__atomic_compare_exchange_n(&sif_file->info.timestamps, &expected, timestamps, 0,
+                                                   __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        sif_mem_free(sif_file->info.alloc, timestamps);
+        timestamps = expected;
+    }
+    return timestamps;
+}
+
+// frames frame_list[0..count) or, without a list, start_frame + i * stride.
+// Runs of neighbouring frames are read in one go; other frames are read on
+// their own, so the frames in between are never touched. Reads of a plain
+// file are announced to the kernel a few frames ahead, which lets a cold
+// disk work on several of them at once.
+static int read_sampled_frames(const SifFile *sif_file, const int *frame_list, int start_frame, int stride,
+                               int count, float *output_buffer, int enable_byte_swap) {
+    size_t frame_size = sif_file->info.pixels_per_frame;
+    size_t frame_bytes = frame_size * sizeof(float);
+    int fd = (!sif_file->map_base && !sif_file->decoder && sif_file->file_ptr) ? fileno(sif_file->file_ptr) : -1;
+    int advised = 0;
+
+    for (int i = 0; i < count; i++) {
+        int frame = frame_list ? frame_list[i] : start_frame + i * stride;
+        if (frame < 0 || frame >= sif_file->frame_count) {
+            return -1;
+        }
+    }
+
+    int i = 0;
+    while (i < count) {
+        int first = frame_list ? frame_list[i] : start_frame + i * stride;
+        int run = 1;
+        while (i + run < count && (frame_list ? frame_list[i + run] : start_frame + (i + run) * stride) == first + run) {
+            run++;
+        }
+
+#ifdef POSIX_FADV_WILLNEED
+        if (fd >= 0) {
+            for (; advised < count && advised <= i + SIF_SAMPLE_ADVISE_AHEAD; advised++) {
+                int frame = frame_list ? frame_list[advised] : start_frame + advised * stride;
+                posix_fadvise(fd, (off_t)sif_frame_offset(sif_file, frame), (off_t)frame_bytes, POSIX_FADV_WILLNEED);
+            }
+        }
+#else
+        (void)fd;
+        (void)advised;
+#endif
+
+        size_t span = (size_t)run * frame_size;
+        ssize_t got = read_pixels(sif_file, sif_frame_offset(sif_file, first), output_buffer + (size_t)i * frame_size,
+                                  span, enable_byte_swap);
+        size_t read_count = got < 0 ? 0 : (size_t)got;
+        if (read_count != span) {
+            const SifLogSink *previous_log = sif_log_enter(&sif_file->info);
+            PRINT_SILENT("⚠️ Frames %d-%d: Only read %zu/%zu pixels\n", first, first + run - 1, read_count, span);
+            sif_log_leave(previous_log);
+            return -1;
+        }
+        i += run;
+    }
     return 0;
 }
 
+int sif_read_frames_strided(const SifFile *sif_file, int start_frame, int stride, int frame_count,
+                            float *output_buffer, int enable_byte_swap) {
+    if (!sif_file || (!sif_file->file_ptr && !sif_file->map_base) || !output_buffer || frame_count <= 0 ||
+        stride <= 0) {
+        return -1;
+    }
+    if (start_frame < 0 || (int64_t)start_frame + (int64_t)(frame_count - 1) * stride >= sif_file->frame_count) {
+        return -1;
+    }
+    return read_sampled_frames(sif_file, NULL, start_frame, stride, frame_count, output_buffer, enable_byte_swap);
+}
+
+int sif_read_frame_list(const SifFile *sif_file, const int *frame_indices, int count,
+                        float *output_buffer, int enable_byte_swap) {
+    if (!sif_file || (!sif_file->file_ptr && !sif_file->map_base) || !frame_indices || !output_buffer || count <= 0) {
+        return -1;
+    }
+    return read_sampled_frames(sif_file, frame_indices, 0, 0, count, output_buffer, enable_byte_swap);
+}
+
+int sif_decimate_frames(const SifFile *sif_file, int target_frames, int *frame_indices) {
+    if (!sif_file || !frame_indices || target_frames <= 0 || sif_file->frame_count <= 0) {
+        return -1;
+    }
+
+    int total = sif_file->frame_count;
+    if (target_frames >= total) {
+        for (int i = 0; i < total; i++) frame_indices[i] = i;
+        return total;
+    }
+    if (target_frames == 1) {
+        frame_indices[0] = 0;
+        return 1;
+    }
+
+    // first and last frame included, steps of at least one frame
+    for (int i = 0; i < target_frames; i++) {
+        frame_indices[i] = (int)((int64_t)i * (total - 1) / (target_frames - 1));
+    }
+    return target_frames;
+}
+
+float *sif_load_decimated(const SifFile *sif_file, int target_frames, int enable_byte_swap, int *frame_count) {
+    if (!sif_file || target_frames <= 0 || sif_file->frame_count <= 0) {
+        return NULL;
+    }
+
+    int count = target_frames < sif_file->frame_count ? target_frames : sif_file->frame_count;
+    size_t frame_size = sif_file->info.pixels_per_frame;
+    if (frame_size == 0 || frame_size > SIZE_MAX / sizeof(float) / (size_t)count) {
+        return NULL;
+    }
+
+    int *indices = sif_mem_alloc(sif_file->info.alloc, (size_t)count * sizeof(int));
+    // handed to the caller: the process-wide allocator, like retrieve_calibration
+    float *data = sif_mem_alloc(NULL, (size_t)count * frame_size * sizeof(float));
+    if (!indices || !data || sif_decimate_frames(sif_file, target_frames, indices) != count ||
+        sif_read_frame_list(sif_file, indices, count, data, enable_byte_swap) != 0) {
+        sif_mem_free(sif_file->info.alloc, indices);
+        sif_free(data);
+        return NULL;
+    }
+
+    sif_mem_free(sif_file->info.alloc, indices);
+    if (frame_count) *frame_count = count;
+    return data;
+}
+
+int64_t sif_read_pixels(const SifFile *sif_file, int64_t offset, float *output_buffer,
+                        size_t pixel_count, int enable_byte_swap) {
+    if (!sif_file || !output_buffer || (!sif_file->map_base && !sif_file->file_ptr)) {
+        return -1;
+    }
+    return read_pixels(sif_file, offset, output_buffer, pixel_count, enable_byte_swap);
+}
+
+// one track (subimage) of a frame; width and height are optional outputs
+float *sif_get_track_data(SifFile *sif_file, int frame_index, int track, int *width, int *height) {
+    if (!sif_file) {
+        return NULL;
+    }
+
+    int tracks = sif_file->info.number_of_subimages;
+    if (tracks > 0 && (track < 0 || track >= tracks || !sif_file->info.subimages)) {
+        return NULL;
+    }
+    if (tracks <= 0 && track != 0) {
+        return NULL;
+    }
+
+    float *frame = sif_get_frame_data(sif_file, frame_index);
+    if (!frame) {
+        return NULL;
+    }
+
+    if (tracks <= 0) {
+        if (width) *width = sif_file->info.image_width;
+        if (height) *height = sif_file->info.image_height;
+        return frame;
+    }
+
+    const SubImageInfo *sub = &sif_file->info.subimages[track];
+    if (width) *width = sub->width;
+    if (height) *height = sub->height;
+    return frame + sub->offset;
+}
+
 void sif_unload_data(SifFile *sif_file) {
     if (!sif_file) return;
     
-    if (sif_file->frame_data) {
-        free(sif_file->frame_data);
+    if (sif_file->data_mapped) {
+        // points into the mapping, nothing to free
+        sif_file->frame_data = NULL;
+        sif_file->data_mapped = 0;
+    } else if (sif_file->frame_data) {
+        sif_mem_free(sif_file->info.alloc, sif_file->frame_data);
         sif_file->frame_data = NULL;
     }
     sif_file->data_loaded = 0;
+    sif_file->first_loaded_frame = 0;
+    sif_file->loaded_frame_count = 0;
 }
 
 static void cleanup_sif_info(SifInfo *info) {
     if (!info) return;
     
     if (info->timestamps) {
-        free(info->timestamps);
+        sif_mem_free(info->alloc, info->timestamps);
         info->timestamps = NULL;
     }
+
+    if (info->frame_calibrations) {
+        sif_mem_free(info->alloc, info->frame_calibrations);
+        info->frame_calibrations = NULL;
+    }
     
-    if (info->calibration_data) {
-        info->calibration_data[0] = '\0';  
+    if (info->subimages) {
+        sif_mem_free(info->alloc, info->subimages);
+        info->subimages = NULL;
     }
+
+    sif_mem_free(info->alloc, info->user_text);
+    info->user_text = NULL;
+    sif_mem_free(info->alloc, info->calibration_data);
+    info->calibration_data = NULL;
+
+    // interned strings are shared with other open files
+    sif_intern_release(info->detector_type);
+    sif_intern_release(info->original_filename);
+    sif_intern_release(info->spectrograph);
+    sif_intern_release(info->frame_axis);
+    sif_intern_release(info->data_type);
+    sif_intern_release(info->image_axis);
+    info->detector_type = info->original_filename = info->spectrograph = NULL;
+    info->frame_axis = info->data_type = info->image_axis = NULL;
 }
-void sif_close(SifFile *sif_file) {
-    if (!sif_file) return;
-    
-    PRINT_VERBOSE("→ Closing SIF file and freeing resources...\n");
-    
+// a buffer of `bytes` for the handle: the one sif_reset kept from the
+// previous file when it has exactly that size, else a new allocation
+static void *take_buffer(SifFile *sif_file, SifSpareBuffer *spare, size_t bytes) {
+    if (spare->data && spare->bytes == bytes) {
+        void *data = spare->data;
+        spare->data = NULL;
+        spare->bytes = 0;
+        return data;
+    }
+
+    void *data = sif_mem_alloc(sif_file->info.alloc, bytes);
+    if (data) {
+        SIF_STATS_ALLOC(sif_file->stats, bytes);
+    }
+    return data;
+}
+
+static void release_spare(SifFile *sif_file, SifSpareBuffer *spare) {
+    sif_mem_free(sif_file->info.alloc, spare->data);
+    spare->data = NULL;
+    spare->bytes = 0;
+}
+
+// everything that belongs to the open file rather than to the handle
+static void release_file(SifFile *sif_file) {
     // release frames 
     sif_unload_data(sif_file);
-    
-    // release tiles array
-    if (sif_file->tiles) {
-        free(sif_file->tiles);
-        sif_file->tiles = NULL;
-        PRINT_VERBOSE("✓ Freed tiles array\n");
+    sif_prefetch_disable(sif_file);
+    sif_cache_disable(sif_file);
+    
+    // release the file mapping (a sif_open_memory buffer stays the caller's)
+    if (sif_file->map_base) {
+        if (!sif_file->map_borrowed) {
+            munmap(sif_file->map_base, sif_file->map_length);
+            PRINT_VERBOSE("✓ Unmapped file\n");
+        }
+        sif_file->map_base = NULL;
+        sif_file->map_length = 0;
+        sif_file->map_borrowed = 0;
     }
-    
+
+    sif_decoder_close(sif_file->decoder);
+    sif_file->decoder = NULL;
+
     // clean the dynamic memory of info struct 
     cleanup_sif_info(&sif_file->info);
+}
+
+void sif_close(SifFile *sif_file) {
+    if (!sif_file) return;
+    
+    const SifLogSink *previous_log = sif_log_enter(&sif_file->info);
+    PRINT_VERBOSE("→ Closing SIF file and freeing resources...\n");
+    
+    release_file(sif_file);
+    release_spare(sif_file, &sif_file->spare_frames);
+    release_spare(sif_file, &sif_file->spare_timestamps);
+    release_spare(sif_file, &sif_file->spare_subimages);
+
+    // with an arena this hands back every remaining block at once
+    sif_alloc_destroy(sif_file->info.alloc);
+    sif_file->info.alloc = NULL;
+
+    sif_stats_destroy(sif_file->stats);
+    sif_file->stats = NULL;
+    sif_file->info.stats = NULL;
+    pthread_mutex_destroy(&sif_file->info.calibration_lock);
     
     // reset counter
     sif_file->frame_count = 0;
-    sif_file->tile_count = 0;
     sif_file->data_loaded = 0;
     
     // note: not close file_ptr，this will be handled by the user in debugging
     sif_file->file_ptr = NULL;
     
     PRINT_VERBOSE("✓ SIF file closed successfully\n");
+    sif_log_leave(previous_log);
+}
+
+void sif_reset(SifFile *sif_file) {
+    if (!sif_file) return;
+
+    SifInfo *info = &sif_file->info;
+    const SifLogSink *previous_log = sif_log_enter(info);
+    PRINT_VERBOSE("→ Resetting handle for the next file...\n");
+
+    // take the buffers the next file of the same shape needs again out of
+    // the handle before the rest is released; older spares were not used
+    release_spare(sif_file, &sif_file->spare_frames);
+    release_spare(sif_file, &sif_file->spare_timestamps);
+    release_spare(sif_file, &sif_file->spare_subimages);
+    if (sif_file->frame_data && !sif_file->data_mapped) {
+        sif_file->spare_frames.data = sif_file->frame_data;
+        sif_file->spare_frames.bytes = (size_t)sif_file->loaded_frame_count * info->pixels_per_frame * sizeof(float);
+        sif_file->frame_data = NULL;
+    }
+    if (info->timestamps) {
+        sif_file->spare_timestamps.data = info->timestamps;
+        sif_file->spare_timestamps.bytes = (size_t)info->number_of_frames * sizeof(int64_t);
+        info->timestamps = NULL;
+    }
+    if (info->subimages) {
+        sif_file->spare_subimages.data = info->subimages;
+        sif_file->spare_subimages.bytes = (size_t)info->number_of_subimages * sizeof(SubImageInfo);
+        info->subimages = NULL;
+    }
+
+    release_file(sif_file);
+
+    // an arena starts over in the chunks it already has, which also hold
+    // the small spares; only its large blocks can be carried over
+    SifSpareBuffer *spares[] = { &sif_file->spare_frames, &sif_file->spare_timestamps, &sif_file->spare_subimages };
+    for (size_t i = 0; i < sizeof(spares) / sizeof(spares[0]); i++) {
+        if (!sif_mem_survives_rewind(info->alloc, spares[i]->data)) {
+            spares[i]->data = NULL;
+            spares[i]->bytes = 0;
+        }
+    }
+    sif_alloc_rewind(info->alloc);
+
+    // back to a blank handle with the same settings
+    pthread_mutex_destroy(&info->calibration_lock);
+    SifFile kept = *sif_file;
+    memset(sif_file, 0, sizeof(SifFile));
+    pthread_mutex_init(&info->calibration_lock, NULL);
+    info->log = kept.info.log;
+    info->has_log = kept.info.has_log;
+    info->alloc = kept.info.alloc;
+    info->user_text_kept = kept.info.user_text_kept;
+    sif_file->stats = kept.stats;
+    info->stats = kept.stats;
+    sif_file->lazy_timestamps = kept.lazy_timestamps;
+    sif_file->spare_frames = kept.spare_frames;
+    sif_file->spare_timestamps = kept.spare_timestamps;
+    sif_file->spare_subimages = kept.spare_subimages;
+
+    sif_log_leave(previous_log);
+}
+
+int sif_reopen(SifFile *sif_file, FILE *fp) {
+    if (!sif_file || !fp) return -1;
+
+    sif_reset(sif_file);
+    sif_file->file_ptr = fp;
+    init_sif_info(&sif_file->info);
+
+    SifReader reader;
+    if (reader_init_file(&reader, sif_file, fp, SIF_READER_CHUNK) != 0) {
+        return -1;
+    }
+
+    SifOpenOptions options = SIF_DEFAULT_OPEN_OPTIONS;
+    options.keep_user_text = sif_file->info.user_text_kept;
+    options.lazy_timestamps = sif_file->lazy_timestamps;
+    int result = parse_handle(sif_file, &reader, options);
+
+    if (!sif_file->decoder) {
+        fseek(fp, reader_tell(&reader), SEEK_SET);
+        SIF_STATS_SEEK(sif_file->stats);
+    }
+    reader_free(&reader);
+    if (result != 0) {
+        sif_decoder_close(sif_file->decoder);
+        sif_file->decoder = NULL;
+    }
+
+    // the header tables have been taken over or do not fit. Frames are
+    // only loaded later: keep their buffer while it holds whole frames of
+    // this geometry, a load of as many frames takes it over.
+    release_spare(sif_file, &sif_file->spare_timestamps);
+    release_spare(sif_file, &sif_file->spare_subimages);
+    size_t frame_bytes = sif_file->info.pixels_per_frame * sizeof(float);
+    if (result != 0 || frame_bytes == 0 || sif_file->spare_frames.bytes % frame_bytes != 0 ||
+        sif_file->spare_frames.bytes > (size_t)sif_file->frame_count * frame_bytes) {
+        release_spare(sif_file, &sif_file->spare_frames);
+    }
+
+    return result;
 }
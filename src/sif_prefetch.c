@@ -0,0 +1,582 @@
+/*
+ * csif - Andor SIF Parser in C
+ * Copyright (C) 2025 mithgil
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#define _GNU_SOURCE  // syscall
+
+#include "sif_prefetch.h"
+#include "sif_utils.h"
+#include "sif_stats.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef SIF_HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+#define SIF_PREFETCH_MAX_DEPTH 64
+
+typedef enum {
+    SLOT_EMPTY = 0,
+    SLOT_IN_FLIGHT,               // read submitted, not yet completed
+    SLOT_READY                    // holds frame_index
+} SlotState;
+
+typedef struct {
+    float *data;
+    int frame_index;
+    SlotState state;
+    int swapped;                  // byte swap already applied
+    int64_t result;               // bytes read, or -errno
+} PrefetchSlot;
+
+#ifdef SIF_HAVE_IO_URING
+// minimal io_uring ring, driven through the raw syscalls (no liburing)
+typedef struct {
+    int fd;
+    unsigned entries;
+
+    void *sq_ring;
+    size_t sq_ring_size;
+    void *cq_ring;
+    size_t cq_ring_size;
+    struct io_uring_sqe *sqes;
+    size_t sqes_size;
+
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    struct io_uring_cqe *cqes;
+} UringRing;
+#endif
+
+struct SifPrefetcher {
+    SifPrefetchBackend backend;
+    int fd;
+    int depth;
+    int enable_byte_swap;
+    struct SifStatsState *stats;  // the handle's counters, NULL when not counting
+    struct SifAllocState *alloc;  // the handle's allocator
+    struct SifAllocState *buffer_alloc; // slot buffers: NULL (process-wide) for the ring
+
+    size_t frame_pixels;
+    PrefetchSlot *slots;
+    int slot_count;
+    int in_flight;
+    int current_slot;             // slot handed to the consumer last
+
+    // access pattern detection
+    int last_frame;
+    int last_stride;
+    int stride_hits;              // consecutive accesses with last_stride
+    int advised_stride;           // pread: stride the kernel was last told about
+    int advised_frame;            // pread: furthest frame announced along it
+
+    // waiting on the ring failed: the reads still in flight are abandoned,
+    // their slots are never reused or freed and no new reads are submitted
+    int broken;
+
+#ifdef SIF_HAVE_IO_URING
+    UringRing ring;
+#endif
+};
+
+static int read_slot_sync(SifFile *sif_file, PrefetchSlot *slot, int frame_index);
+static void finish_slot(struct SifPrefetcher *pf, PrefetchSlot *slot);
+static int find_slot(struct SifPrefetcher *pf, int frame_index);
+static int pick_victim(struct SifPrefetcher *pf, int frame_index, int stride);
+static void update_pattern(struct SifPrefetcher *pf, int frame_index);
+static void issue_prefetches(SifFile *sif_file, int frame_index);
+static void advise_prefetches(SifFile *sif_file, int frame_index);
+
+#ifdef SIF_HAVE_IO_URING
+static int uring_init(UringRing *ring, unsigned entries);
+static void uring_free(UringRing *ring);
+static int uring_submit_read(UringRing *ring, int fd, void *buffer, unsigned length, int64_t offset, uint64_t user_data);
+static int uring_reap(struct SifPrefetcher *pf, int wait);
+#endif
+
+#ifdef SIF_HAVE_IO_URING
+static int uring_init(UringRing *ring, unsigned entries) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    memset(ring, 0, sizeof(UringRing));
+    ring->fd = -1;
+
+    int fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+    if (fd < 0) {
+        return -1;
+    }
+    ring->fd = fd;
+    ring->entries = params.sq_entries;
+
+    ring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        if (ring->cq_ring_size > ring->sq_ring_size) ring->sq_ring_size = ring->cq_ring_size;
+        ring->cq_ring_size = ring->sq_ring_size;
+    }
+
+    ring->sq_ring = mmap(NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (ring->sq_ring == MAP_FAILED) {
+        ring->sq_ring = NULL;
+        uring_free(ring);
+        return -1;
+    }
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        ring->cq_ring = ring->sq_ring;
+    } else {
+        ring->cq_ring = mmap(NULL, ring->cq_ring_size, PROT_READ | PROT_WRITE,
+                             MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (ring->cq_ring == MAP_FAILED) {
+            ring->cq_ring = NULL;
+            uring_free(ring);
+            return -1;
+        }
+    }
+
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED) {
+        ring->sqes = NULL;
+        uring_free(ring);
+        return -1;
+    }
+
+    unsigned char *sq = ring->sq_ring;
+    unsigned char *cq = ring->cq_ring;
+    ring->sq_head = (unsigned *)(sq + params.sq_off.head);
+    ring->sq_tail = (unsigned *)(sq + params.sq_off.tail);
+    ring->sq_mask = (unsigned *)(sq + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned *)(sq + params.sq_off.array);
+    ring->cq_head = (unsigned *)(cq + params.cq_off.head);
+    ring->cq_tail = (unsigned *)(cq + params.cq_off.tail);
+    ring->cq_mask = (unsigned *)(cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+
+    return 0;
+}
+
+static void uring_free(UringRing *ring) {
+    if (ring->sqes) munmap(ring->sqes, ring->sqes_size);
+    if (ring->cq_ring && ring->cq_ring != ring->sq_ring) munmap(ring->cq_ring, ring->cq_ring_size);
+    if (ring->sq_ring) munmap(ring->sq_ring, ring->sq_ring_size);
+    if (ring->fd >= 0) close(ring->fd);
+
+    memset(ring, 0, sizeof(UringRing));
+    ring->fd = -1;
+}
+
+static int uring_submit_read(UringRing *ring, int fd, void *buffer, unsigned length, int64_t offset, uint64_t user_data) {
+    unsigned tail = *ring->sq_tail;
+    unsigned head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+    if (tail - head >= ring->entries) {
+        return -1; // submission queue full
+    }
+
+    unsigned index = tail & *ring->sq_mask;
+    struct io_uring_sqe *sqe = &ring->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = fd;
+    sqe->addr = (uint64_t)(uintptr_t)buffer;
+    sqe->len = length;
+    sqe->off = (uint64_t)offset;
+    sqe->user_data = user_data;
+
+    ring->sq_array[index] = index;
+    __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+    int submitted;
+    do {
+        submitted = (int)syscall(__NR_io_uring_enter, ring->fd, 1, 0, 0, NULL, 0);
+    } while (submitted < 0 && errno == EINTR);
+    if (submitted == 1) return 0;
+
+    // the kernel moves sq_head past every SQE it takes, and a taken one always
+    // completes. One it left behind is withdrawn, or the next enter would
+    // hand it over after its slot has been reused.
+    if (__atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE) == tail) {
+        __atomic_store_n(ring->sq_tail, tail, __ATOMIC_RELEASE);
+        return -1;
+    }
+    return 0;
+}
+
+// collect completions; with wait set, block until at least one arrives
+static int uring_reap(struct SifPrefetcher *pf, int wait) {
+    UringRing *ring = &pf->ring;
+
+    if (wait) {
+        if (pf->broken) return -1;
+
+        int rc;
+        do {
+            rc = (int)syscall(__NR_io_uring_enter, ring->fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+        } while (rc < 0 && errno == EINTR);
+        if (rc < 0) {
+            // completions can still be picked up without waiting, which hands
+            // an abandoned slot back once its read has landed
+            pf->broken = 1;
+            for (int i = 0; i < pf->slot_count; i++) {
+                if (pf->slots[i].state == SLOT_IN_FLIGHT) pf->slots[i].frame_index = -1;
+            }
+            PRINT_SILENT("⚠️ Prefetch: Cannot wait for io_uring reads (%s), frames are read synchronously\n",
+                         strerror(errno));
+            return -1;
+        }
+    }
+
+    unsigned head = *ring->cq_head;
+    unsigned tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+    int reaped = 0;
+
+    while (head != tail) {
+        struct io_uring_cqe *cqe = &ring->cqes[head & *ring->cq_mask];
+        PrefetchSlot *slot = &pf->slots[cqe->user_data];
+
+        slot->result = cqe->res;
+        slot->state = SLOT_READY;
+        SIF_STATS_READ(pf->stats, cqe->res < 0 ? 0 : (uint64_t)cqe->res, 1);
+        pf->in_flight--;
+        reaped++;
+        head++;
+    }
+
+    __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+    return reaped;
+}
+#endif
+
+int sif_prefetch_enable(SifFile *sif_file, int depth, int enable_byte_swap) {
+    if (!sif_file || !sif_file->file_ptr || sif_file->frame_count == 0 || sif_file->info.pixels_per_frame == 0) {
+        return -1;
+    }
+
+    if (sif_file->prefetcher) {
+        sif_prefetch_disable(sif_file);
+    }
+
+    if (depth < 1) depth = 1;
+    if (depth > SIF_PREFETCH_MAX_DEPTH) depth = SIF_PREFETCH_MAX_DEPTH;
+
+    struct SifPrefetcher *pf = sif_mem_calloc(sif_file->info.alloc, 1, sizeof(struct SifPrefetcher));
+    if (!pf) return -1;
+
+    pf->alloc = sif_file->info.alloc;
+    pf->fd = fileno(sif_file->file_ptr);
+    pf->depth = depth;
+    pf->enable_byte_swap = enable_byte_swap;
+    pf->frame_pixels = (size_t)sif_file->info.pixels_per_frame;
+    pf->stats = sif_file->stats;
+    pf->current_slot = -1;
+    pf->last_frame = -1;
+
+    // the frame being consumed plus `depth` frames in flight ahead of it
+    pf->slot_count = depth + 1;
+    pf->slots = sif_mem_calloc(pf->alloc, pf->slot_count, sizeof(PrefetchSlot));
+    if (!pf->slots) {
+        sif_mem_free(pf->alloc, pf);
+        return -1;
+    }
+
+    pf->backend = SIF_PREFETCH_PREAD;
+    pf->buffer_alloc = pf->alloc;
+#ifdef SIF_HAVE_IO_URING
+    // the ring reads file bytes, a compressed file has to be decoded
+    if (sif_file->decoder) {
+        PRINT_VERBOSE("  Compressed file, prefetch uses synchronous reads\n");
+    } else if (uring_init(&pf->ring, (unsigned)pf->slot_count) == 0) {
+        pf->backend = SIF_PREFETCH_IO_URING;
+        // an abandoned read keeps its buffer, which must then outlive the
+        // handle's arena
+        pf->buffer_alloc = NULL;
+    } else {
+        PRINT_VERBOSE("  io_uring unavailable, prefetch falls back to pread\n");
+    }
+#endif
+
+    for (int i = 0; i < pf->slot_count; i++) {
+        pf->slots[i].data = sif_mem_alloc(pf->buffer_alloc, pf->frame_pixels * sizeof(float));
+        pf->slots[i].frame_index = -1;
+        if (!pf->slots[i].data) {
+            for (int j = 0; j < i; j++) sif_mem_free(pf->buffer_alloc, pf->slots[j].data);
+#ifdef SIF_HAVE_IO_URING
+            if (pf->backend == SIF_PREFETCH_IO_URING) uring_free(&pf->ring);
+#endif
+            sif_mem_free(pf->alloc, pf->slots);
+            sif_mem_free(pf->alloc, pf);
+            return -1;
+        }
+        SIF_STATS_ALLOC(pf->stats, pf->frame_pixels * sizeof(float));
+    }
+
+    sif_file->prefetcher = pf;
+    PRINT_VERBOSE("✓ Frame prefetch enabled: depth %d, backend %s\n", depth,
+           pf->backend == SIF_PREFETCH_IO_URING ? "io_uring" : "pread");
+    return 0;
+}
+
+void sif_prefetch_disable(SifFile *sif_file) {
+    if (!sif_file || !sif_file->prefetcher) return;
+
+    struct SifPrefetcher *pf = sif_file->prefetcher;
+
+#ifdef SIF_HAVE_IO_URING
+    if (pf->backend == SIF_PREFETCH_IO_URING) {
+        // the kernel still owns buffers of reads in flight
+        while (pf->in_flight > 0 && uring_reap(pf, 1) >= 0) {
+        }
+        if (pf->in_flight > 0) {
+            PRINT_SILENT("⚠️ Prefetch: %d reads never completed, their buffers are left allocated\n",
+                         pf->in_flight);
+        }
+        uring_free(&pf->ring);
+    }
+#endif
+
+    for (int i = 0; i < pf->slot_count; i++) {
+        if (pf->slots[i].state == SLOT_IN_FLIGHT) continue;
+        sif_mem_free(pf->buffer_alloc, pf->slots[i].data);
+    }
+    sif_mem_free(pf->alloc, pf->slots);
+    sif_mem_free(pf->alloc, pf);
+
+    sif_file->prefetcher = NULL;
+}
+
+SifPrefetchBackend sif_prefetch_backend(const SifFile *sif_file) {
+    if (!sif_file || !sif_file->prefetcher) return SIF_PREFETCH_NONE;
+    return sif_file->prefetcher->backend;
+}
+
+static int read_slot_sync(SifFile *sif_file, PrefetchSlot *slot, int frame_index) {
+    struct SifPrefetcher *pf = sif_file->prefetcher;
+    size_t bytes = pf->frame_pixels * sizeof(float);
+
+    SIF_STATS_START(read_start);
+    int64_t got = sif_read_at(sif_file, slot->data, bytes, sif_frame_offset(sif_file, frame_index));
+    SIF_STATS_READ(pf->stats, got < 0 ? 0 : (uint64_t)got, 1);
+    SIF_STATS_PHASE(pf->stats, SIF_PHASE_FRAME_READ, read_start, got < 0 ? 0 : (uint64_t)got);
+    slot->frame_index = frame_index;
+    slot->state = SLOT_READY;
+    slot->swapped = 0;
+    slot->result = got < 0 ? -errno : got;
+    return got < 0 ? -1 : 0;
+}
+
+// a completed read becomes usable: check its size and apply the byte swap
+static void finish_slot(struct SifPrefetcher *pf, PrefetchSlot *slot) {
+    if (slot->swapped || slot->result < 0) return;
+
+    size_t bytes = pf->frame_pixels * sizeof(float);
+    if ((size_t)slot->result < bytes) {
+        PRINT_SILENT("⚠️ Frame %d: Only read %zu/%zu pixels\n", slot->frame_index,
+               (size_t)slot->result / sizeof(float), pf->frame_pixels);
+        memset((unsigned char *)slot->data + slot->result, 0, bytes - (size_t)slot->result);
+    }
+
+    if (pf->enable_byte_swap) {
+        SIF_STATS_START(swap_start);
+        swap_float_array_endian(slot->data, pf->frame_pixels);
+        SIF_STATS_PHASE(pf->stats, SIF_PHASE_BYTE_SWAP, swap_start, bytes);
+    }
+    slot->swapped = 1;
+}
+
+static int find_slot(struct SifPrefetcher *pf, int frame_index) {
+    for (int i = 0; i < pf->slot_count; i++) {
+        if (pf->slots[i].state != SLOT_EMPTY && pf->slots[i].frame_index == frame_index) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// a slot that is neither in flight, nor the consumer's current frame, nor
+// one of the frames predicted next; prefer empty slots
+static int pick_victim(struct SifPrefetcher *pf, int frame_index, int stride) {
+    int fallback = -1;
+
+    for (int i = 0; i < pf->slot_count; i++) {
+        PrefetchSlot *slot = &pf->slots[i];
+        if (i == pf->current_slot || slot->state == SLOT_IN_FLIGHT) continue;
+        if (slot->state == SLOT_EMPTY) return i;
+
+        int predicted = 0;
+        if (stride != 0) {
+            int distance = slot->frame_index - frame_index;
+            predicted = distance % stride == 0 && distance / stride >= 0 && distance / stride <= pf->depth;
+        }
+        if (!predicted) return i;
+        if (fallback < 0) fallback = i;
+    }
+
+    return stride == 0 ? fallback : -1;
+}
+
+static void update_pattern(struct SifPrefetcher *pf, int frame_index) {
+    if (pf->last_frame >= 0) {
+        int stride = frame_index - pf->last_frame;
+        if (stride != 0 && stride == pf->last_stride) {
+            pf->stride_hits++;
+        } else {
+            pf->stride_hits = 0;
+        }
+        pf->last_stride = stride;
+    }
+    pf->last_frame = frame_index;
+}
+
+// without a ring the reads stay synchronous, but the kernel is told which
+// frames come next (as read_sampled_frames does) and pulls them into the
+// page cache meanwhile. Each frame is announced once.
+static void advise_prefetches(SifFile *sif_file, int frame_index) {
+#ifdef POSIX_FADV_WILLNEED
+    struct SifPrefetcher *pf = sif_file->prefetcher;
+    // a compressed file's frame offsets are not offsets into the file
+    if (sif_file->decoder) return;
+
+    int stride = pf->last_stride;
+    if (stride != pf->advised_stride) {
+        pf->advised_stride = stride;
+        pf->advised_frame = frame_index;
+    }
+
+    for (int k = 1; k <= pf->depth; k++) {
+        int64_t next = (int64_t)frame_index + (int64_t)k * stride;
+        if (next < 0 || next >= sif_file->frame_count) break;
+        if (stride > 0 ? next <= pf->advised_frame : next >= pf->advised_frame) continue;
+
+        posix_fadvise(pf->fd, (off_t)sif_frame_offset(sif_file, next), (off_t)(pf->frame_pixels * sizeof(float)),
+                      POSIX_FADV_WILLNEED);
+        pf->advised_frame = (int)next;
+    }
+#else
+    (void)sif_file;
+    (void)frame_index;
+#endif
+}
+
+// once the same stride has been seen twice in a row, keep the next `depth`
+// frames along it in flight
+static void issue_prefetches(SifFile *sif_file, int frame_index) {
+    struct SifPrefetcher *pf = sif_file->prefetcher;
+    if (pf->stride_hits < 1) return;
+    if (pf->backend != SIF_PREFETCH_IO_URING || pf->broken) {
+        advise_prefetches(sif_file, frame_index);
+        return;
+    }
+
+#ifdef SIF_HAVE_IO_URING
+    int stride = pf->last_stride;
+    for (int k = 1; k <= pf->depth; k++) {
+        int64_t next = (int64_t)frame_index + (int64_t)k * stride;
+        if (next < 0 || next >= sif_file->frame_count) break;
+        if (find_slot(pf, (int)next) >= 0) continue;
+
+        int victim = pick_victim(pf, frame_index, stride);
+        if (victim < 0) break;
+
+        PrefetchSlot *slot = &pf->slots[victim];
+        slot->frame_index = (int)next;
+        slot->swapped = 0;
+        slot->result = 0;
+        slot->state = SLOT_IN_FLIGHT;
+
+        if (uring_submit_read(&pf->ring, pf->fd, slot->data, (unsigned)(pf->frame_pixels * sizeof(float)),
+                              sif_frame_offset(sif_file, next), (uint64_t)victim) != 0) {
+            // nothing was queued, the slot is free again
+            slot->state = SLOT_EMPTY;
+            slot->frame_index = -1;
+            break;
+        }
+        pf->in_flight++;
+    }
+#else
+    (void)frame_index;
+#endif
+}
+
+float *sif_prefetch_get_frame(SifFile *sif_file, int frame_index) {
+    if (!sif_file || !sif_file->prefetcher || frame_index < 0 || frame_index >= sif_file->frame_count) {
+        return NULL;
+    }
+
+    struct SifPrefetcher *pf = sif_file->prefetcher;
+
+#ifdef SIF_HAVE_IO_URING
+    if (pf->backend == SIF_PREFETCH_IO_URING && pf->in_flight > 0) {
+        uring_reap(pf, 0);
+    }
+#endif
+
+    update_pattern(pf, frame_index);
+
+    int index = find_slot(pf, frame_index);
+
+#ifdef SIF_HAVE_IO_URING
+    // already requested: wait for that read to land
+    while (index >= 0 && pf->slots[index].state == SLOT_IN_FLIGHT) {
+        if (uring_reap(pf, 1) < 0) {
+            // cannot wait on the ring any more: the slot stays with the
+            // kernel and the frame is read into another one
+            index = -1;
+        }
+    }
+#endif
+
+    if (index < 0) {
+        index = pick_victim(pf, frame_index, 0);
+#ifdef SIF_HAVE_IO_URING
+        // every other slot is in flight: free one up
+        while (index < 0 && pf->in_flight > 0 && uring_reap(pf, 1) >= 0) {
+            index = pick_victim(pf, frame_index, 0);
+        }
+#endif
+        if (index < 0) return NULL;
+        if (read_slot_sync(sif_file, &pf->slots[index], frame_index) != 0) {
+            pf->slots[index].state = SLOT_EMPTY;
+            return NULL;
+        }
+    }
+
+    PrefetchSlot *slot = &pf->slots[index];
+
+    // reads the ring could not do (e.g. kernel without IORING_OP_READ)
+    if (slot->result < 0 && read_slot_sync(sif_file, slot, frame_index) != 0) {
+        slot->state = SLOT_EMPTY;
+        return NULL;
+    }
+
+    finish_slot(pf, slot);
+    pf->current_slot = index;
+
+    issue_prefetches(sif_file, frame_index);
+    return slot->data;
+}
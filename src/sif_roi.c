@@ -0,0 +1,200 @@
+/*
+ * csif - Andor SIF Parser in C
+ * Copyright (C) 2025 mithgil
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "sif_roi.h"
+#include "sif_utils.h"
+#include "sif_stats.h"
+
+// rows closer than this are read together and the gap dropped in memory:
+// below it one larger read is cheaper than another call
+#define SIF_ROI_MERGE_GAP_BYTES 1024
+// staging for merged rows
+#define SIF_ROI_STAGING_BYTES (256 << 10)
+
+const SifRoi SIF_FULL_ROI = { .track = 0, .x0 = 0, .x1 = 0, .y0 = 0, .y1 = 0 };
+
+typedef struct {
+    size_t first;                 // first ROI pixel within a frame
+    size_t stride;                // pixels from one track row to the next
+    int width;
+    int height;
+} RoiLayout;
+
+static int resolve_roi(const SifFile *sif_file, SifRoi roi, RoiLayout *layout) {
+    const SifInfo *info = &sif_file->info;
+    int track_width, track_height;
+    size_t track_offset;
+
+    if (info->number_of_subimages > 0) {
+        if (!info->subimages || roi.track < 0 || roi.track >= info->number_of_subimages) {
+            return -1;
+        }
+        const SubImageInfo *sub = &info->subimages[roi.track];
+        track_width = sub->width;
+        track_height = sub->height;
+        track_offset = (size_t)sub->offset;
+    } else {
+        if (roi.track != 0) return -1;
+        track_width = info->image_width;
+        track_height = info->image_height;
+        track_offset = 0;
+    }
+
+    int x1 = roi.x1 ? roi.x1 : track_width;
+    int y1 = roi.y1 ? roi.y1 : track_height;
+    if (roi.x0 < 0 || roi.y0 < 0 || roi.x0 >= x1 || roi.y0 >= y1 || x1 > track_width || y1 > track_height) {
+        return -1;
+    }
+    if (track_offset + (size_t)track_width * (size_t)track_height > info->pixels_per_frame) {
+        return -1;
+    }
+
+    layout->first = track_offset + (size_t)roi.y0 * (size_t)track_width + (size_t)roi.x0;
+    layout->stride = (size_t)track_width;
+    layout->width = x1 - roi.x0;
+    layout->height = y1 - roi.y0;
+    return 0;
+}
+
+int sif_roi_size(const SifFile *sif_file, SifRoi roi, int *width, int *height) {
+    if (!sif_file) return -1;
+
+    RoiLayout layout;
+    if (resolve_roi(sif_file, roi, &layout) != 0) return -1;
+
+    if (width) *width = layout.width;
+    if (height) *height = layout.height;
+    return 0;
+}
+
+// one frame's ROI into out
+static int read_frame_roi(const SifFile *sif_file, const RoiLayout *layout, int64_t frame_offset, float *out,
+                          float *staging, size_t staging_pixels, int enable_byte_swap) {
+    size_t width = (size_t)layout->width;
+    int count = layout->height;
+    int64_t row_bytes = (int64_t)(layout->stride * sizeof(float));
+    int64_t offset = frame_offset + (int64_t)(layout->first * sizeof(float));
+
+    // a row band: the rows follow each other in the file
+    if (width == layout->stride) {
+        size_t pixels = (size_t)count * width;
+        return sif_read_pixels(sif_file, offset, out, pixels, enable_byte_swap) == (int64_t)pixels ? 0 : -1;
+    }
+
+    // a column window: one read per row at the track's stride
+    if (!staging) {
+        for (int r = 0; r < count; r++) {
+            if (sif_read_pixels(sif_file, offset + r * row_bytes, out + (size_t)r * width, width,
+                                enable_byte_swap) != (int64_t)width) {
+                return -1;
+            }
+        }
+        return 0;
+    }
+
+    // narrow gaps: read as many whole rows as fit and keep the window
+    int batch_rows = (int)((staging_pixels - width) / layout->stride) + 1;
+    for (int r = 0; r < count; r += batch_rows) {
+        int rows = count - r < batch_rows ? count - r : batch_rows;
+        size_t span = (size_t)(rows - 1) * layout->stride + width;
+        if (sif_read_pixels(sif_file, offset + r * row_bytes, staging, span, enable_byte_swap) != (int64_t)span) {
+            return -1;
+        }
+        for (int k = 0; k < rows; k++) {
+            memcpy(out + (size_t)(r + k) * width, staging + (size_t)k * layout->stride, width * sizeof(float));
+        }
+    }
+    return 0;
+}
+
+int sif_read_roi(const SifFile *sif_file, int start_frame, int frame_count, SifRoi roi,
+                 float *out, int enable_byte_swap) {
+    if (!sif_file || !out || frame_count <= 0) {
+        return -1;
+    }
+    if (start_frame < 0 || start_frame + frame_count > sif_file->frame_count) {
+        return -1;
+    }
+
+    RoiLayout layout;
+    if (resolve_roi(sif_file, roi, &layout) != 0) {
+        return -1;
+    }
+
+    size_t roi_pixels = (size_t)layout.width * (size_t)layout.height;
+
+    // the whole frame: frames are back to back, one read for all of them
+    if (roi_pixels == sif_file->info.pixels_per_frame) {
+        return sif_read_frames(sif_file, start_frame, frame_count, out, enable_byte_swap);
+    }
+
+    // merging rows pays off when the skipped part of each row is small; a
+    // mapping has no per-read cost, so its rows are always copied one by one
+    float *staging = NULL;
+    size_t staging_pixels = 0;
+    size_t gap_bytes = (layout.stride - (size_t)layout.width) * sizeof(float);
+    if (layout.height > 1 && gap_bytes > 0 && gap_bytes < SIF_ROI_MERGE_GAP_BYTES && !sif_file->map_base) {
+        size_t band = (size_t)(layout.height - 1) * layout.stride + (size_t)layout.width;
+        staging_pixels = SIF_ROI_STAGING_BYTES / sizeof(float);
+        if (staging_pixels < layout.stride + (size_t)layout.width) staging_pixels = layout.stride + (size_t)layout.width;
+        if (staging_pixels > band) staging_pixels = band;
+
+        staging = sif_mem_alloc(sif_file->info.alloc, staging_pixels * sizeof(float));
+        if (!staging) return -1;
+        SIF_STATS_ALLOC(sif_file->stats, staging_pixels * sizeof(float));
+    }
+
+    int result = 0;
+    for (int i = 0; i < frame_count && result == 0; i++) {
+        int frame = start_frame + i;
+        result = read_frame_roi(sif_file, &layout, sif_frame_offset(sif_file, frame), out + (size_t)i * roi_pixels,
+                                staging, staging_pixels, enable_byte_swap);
+        if (result != 0) {
+            const SifLogSink *previous_log = sif_log_enter(&sif_file->info);
+            PRINT_SILENT("⚠️ Frame %d: Cannot read the %dx%d region of interest\n", frame, layout.width,
+                         layout.height);
+            sif_log_leave(previous_log);
+        }
+    }
+
+    sif_mem_free(sif_file->info.alloc, staging);
+    return result;
+}
+
+float *sif_load_roi(const SifFile *sif_file, SifRoi roi, int enable_byte_swap, int *width, int *height) {
+    if (!sif_file || sif_file->frame_count <= 0) return NULL;
+
+    int roi_width, roi_height;
+    if (sif_roi_size(sif_file, roi, &roi_width, &roi_height) != 0) return NULL;
+
+    size_t frame_pixels = (size_t)roi_width * (size_t)roi_height;
+    if (frame_pixels > SIZE_MAX / sizeof(float) / (size_t)sif_file->frame_count) return NULL;
+
+    // handed to the caller: the process-wide allocator, like retrieve_calibration
+    float *data = sif_mem_alloc(NULL, (size_t)sif_file->frame_count * frame_pixels * sizeof(float));
+    if (!data) return NULL;
+
+    if (sif_read_roi(sif_file, 0, sif_file->frame_count, roi, data, enable_byte_swap) != 0) {
+        sif_free(data);
+        return NULL;
+    }
+
+    if (width) *width = roi_width;
+    if (height) *height = roi_height;
+    return data;
+}
@@ -0,0 +1,197 @@
+/*
+ * csif - Andor SIF Parser in C
+ * Copyright (C) 2025 mithgil
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#define _POSIX_C_SOURCE 200809L  // clock_gettime
+
+#include "sif_stats.h"
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct {
+    uint64_t start_ns;
+    uint64_t duration_ns;
+    uint64_t bytes;
+    uint32_t thread;
+    SifPhase phase;
+} TraceEvent;
+
+struct SifStatsState {
+    SifStats counters;            // updated with atomic adds
+    uint64_t origin_ns;           // trace timestamps are relative to this
+
+    TraceEvent *events;
+    size_t event_capacity;
+};
+
+static const char *phase_names[SIF_PHASE_COUNT] = {
+    "header_parse", "timestamps", "user_text", "frame_read", "byte_swap", "json", "convert", "calibration"
+};
+
+// small per-thread ids for the trace, in order of first use
+static uint32_t next_thread_id = 1;
+static _Thread_local uint32_t thread_id;
+
+static uint32_t current_thread_id(void) {
+    if (thread_id == 0) {
+        thread_id = __atomic_fetch_add(&next_thread_id, 1, __ATOMIC_RELAXED);
+    }
+    return thread_id;
+}
+
+uint64_t sif_stats_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+struct SifStatsState *sif_stats_create(size_t trace_events) {
+    struct SifStatsState *stats = calloc(1, sizeof(struct SifStatsState));
+    if (!stats) return NULL;
+
+    stats->origin_ns = sif_stats_now();
+
+    if (trace_events > 0) {
+        stats->events = calloc(trace_events, sizeof(TraceEvent));
+        if (stats->events) {
+            stats->event_capacity = trace_events;
+        }
+    }
+    return stats;
+}
+
+void sif_stats_destroy(struct SifStatsState *stats) {
+    if (!stats) return;
+    free(stats->events);
+    free(stats);
+}
+
+void sif_stats_record(struct SifStatsState *stats, SifPhase phase, uint64_t start_ns, uint64_t bytes) {
+    if (!stats || phase < 0 || phase >= SIF_PHASE_COUNT) return;
+
+    uint64_t duration = sif_stats_now() - start_ns;
+    __atomic_fetch_add(&stats->counters.calls[phase], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&stats->counters.nanoseconds[phase], duration, __ATOMIC_RELAXED);
+
+    if (!stats->events) return;
+
+    // claim a slot; events past the capacity are counted but dropped
+    uint64_t slot = __atomic_fetch_add(&stats->counters.trace_events, 1, __ATOMIC_RELAXED);
+    if (slot >= stats->event_capacity) return;
+
+    TraceEvent *event = &stats->events[slot];
+    event->start_ns = start_ns;
+    event->duration_ns = duration;
+    event->bytes = bytes;
+    event->thread = current_thread_id();
+    event->phase = phase;
+}
+
+void sif_stats_add_read(struct SifStatsState *stats, uint64_t bytes, int calls) {
+    if (!stats) return;
+    __atomic_fetch_add(&stats->counters.bytes_read, bytes, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&stats->counters.read_calls, (uint64_t)calls, __ATOMIC_RELAXED);
+}
+
+void sif_stats_add_seek(struct SifStatsState *stats) {
+    if (!stats) return;
+    __atomic_fetch_add(&stats->counters.seek_calls, 1, __ATOMIC_RELAXED);
+}
+
+void sif_stats_add_alloc(struct SifStatsState *stats, uint64_t bytes) {
+    if (!stats) return;
+    __atomic_fetch_add(&stats->counters.bytes_allocated, bytes, __ATOMIC_RELAXED);
+}
+
+int sif_get_stats(const SifFile *sif_file, SifStats *stats) {
+    if (!stats) return -1;
+    memset(stats, 0, sizeof(SifStats));
+    if (!sif_file || !sif_file->stats) return -1;
+
+    const SifStats *counters = &sif_file->stats->counters;
+    for (int i = 0; i < SIF_PHASE_COUNT; i++) {
+        stats->calls[i] = __atomic_load_n(&counters->calls[i], __ATOMIC_RELAXED);
+        stats->nanoseconds[i] = __atomic_load_n(&counters->nanoseconds[i], __ATOMIC_RELAXED);
+    }
+    stats->bytes_read = __atomic_load_n(&counters->bytes_read, __ATOMIC_RELAXED);
+    stats->read_calls = __atomic_load_n(&counters->read_calls, __ATOMIC_RELAXED);
+    stats->seek_calls = __atomic_load_n(&counters->seek_calls, __ATOMIC_RELAXED);
+    stats->bytes_allocated = __atomic_load_n(&counters->bytes_allocated, __ATOMIC_RELAXED);
+    stats->trace_events = __atomic_load_n(&counters->trace_events, __ATOMIC_RELAXED);
+    return 0;
+}
+
+// not synchronized with readers still running on the handle
+void sif_reset_stats(SifFile *sif_file) {
+    if (!sif_file || !sif_file->stats) return;
+    memset(&sif_file->stats->counters, 0, sizeof(SifStats));
+}
+
+const char *sif_phase_name(SifPhase phase) {
+    if (phase < 0 || phase >= SIF_PHASE_COUNT) return "unknown";
+    return phase_names[phase];
+}
+
+int sif_trace_enable(SifFile *sif_file, size_t max_events) {
+    if (!sif_file || !sif_file->stats || max_events == 0) return -1;
+
+    struct SifStatsState *stats = sif_file->stats;
+    TraceEvent *events = calloc(max_events, sizeof(TraceEvent));
+    if (!events) return -1;
+
+    free(stats->events);
+    stats->events = events;
+    stats->event_capacity = max_events;
+    stats->counters.trace_events = 0;
+    return 0;
+}
+
+int sif_trace_write_json(const SifFile *sif_file, const char *path) {
+    if (!sif_file || !sif_file->stats || !sif_file->stats->events || !path) return -1;
+
+    const struct SifStatsState *stats = sif_file->stats;
+    uint64_t recorded = __atomic_load_n(&stats->counters.trace_events, __ATOMIC_RELAXED);
+    size_t count = recorded < stats->event_capacity ? (size_t)recorded : stats->event_capacity;
+
+    FILE *fp = fopen(path, "w");
+    if (!fp) {
+        PRINT_SILENT("❌ Cannot open trace file %s\n", path);
+        return -1;
+    }
+
+    // Trace Event Format: complete ("X") events, microsecond timestamps
+    fprintf(fp, "{\"traceEvents\":[");
+    for (size_t i = 0; i < count; i++) {
+        const TraceEvent *event = &stats->events[i];
+        double ts = (double)(event->start_ns - stats->origin_ns) / 1000.0;
+        double dur = (double)event->duration_ns / 1000.0;
+
+        fprintf(fp, "%s\n{\"name\":\"%s\",\"cat\":\"sif\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,"
+                    "\"pid\":1,\"tid\":%u,\"args\":{\"bytes\":%" PRIu64 "}}",
+                i > 0 ? "," : "", sif_phase_name(event->phase), ts, dur, event->thread, event->bytes);
+    }
+    fprintf(fp, "\n],\"displayTimeUnit\":\"ms\"}\n");
+
+    int failed = ferror(fp);
+    if (fclose(fp) != 0 || failed) {
+        return -1;
+    }
+    return 0;
+}
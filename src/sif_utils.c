@@ -15,16 +15,31 @@
  * You should have received a copy of the GNU General Public License
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
+
+#define _POSIX_C_SOURCE 200809L  // pread
  
 #include "sif_utils.h"
 #include "sif_parser.h"
 #include <ctype.h>
 #include <inttypes.h> 
+#include <limits.h>
 
 #include <stdint.h>
 #include <string.h>
 #include <errno.h>
 #include <math.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <stdlib.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define SIF_SWAP_X86 1
+#elif defined(__aarch64__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define SIF_SWAP_NEON 1
+#endif
 
 static int read_binary_string(FILE *fp, char *buffer, int max_length, int length);
 static int read_line_with_binary_check(FILE *fp, char *buffer, int max_length);
@@ -45,7 +60,7 @@ void trim_trailing_whitespace(char *str) {
 
 void debug_hex_dump(FILE* fp, long debug_pos, int num_bytes_to_dump) {
 
-    if (current_verbose_level < SIF_DEBUG) {
+    if (!SIF_LOG_ENABLED(SIF_DEBUG)) {
         return;  
     }
 
@@ -131,7 +146,7 @@ void debug_hex_dump(FILE* fp, long debug_pos, int num_bytes_to_dump) {
 
 // 結合兩者的多功能調試函數
 void debug_comprehensive(FILE* fp, long debug_pos, int num_lines, int hex_dump_bytes) {
-    if (current_verbose_level < SIF_DEBUG) {
+    if (!SIF_LOG_ENABLED(SIF_DEBUG)) {
         return; 
     }
 
@@ -189,8 +204,155 @@ int32_t read_big_endian_int32(FILE *fp) {
     return value;
 }
 
+// bytes swap: 32-bit byte reversal, dst may equal src. The kernel is picked
+// once per process from what the CPU supports; every variant gives the same
+// bytes, the wide ones just move 16-64 of them per shuffle.
+typedef void (*SwapKernel)(unsigned char *dst, const unsigned char *src, size_t count);
+
+static void swap_kernel_scalar(unsigned char *dst, const unsigned char *src, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        uint32_t temp;
+        memcpy(&temp, src + i * 4, sizeof(uint32_t));
+        temp = ((temp & 0xFF) << 24) | ((temp & 0xFF00) << 8) |
+               ((temp & 0xFF0000) >> 8) | ((temp & 0xFF000000) >> 24);
+        memcpy(dst + i * 4, &temp, sizeof(uint32_t));
+    }
+}
+
+#if SIF_SWAP_X86
+__attribute__((target("ssse3")))
+static void swap_kernel_ssse3(unsigned char *dst, const unsigned char *src, size_t count) {
+    const __m128i mask = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + i * 4));
+        _mm_storeu_si128((__m128i *)(dst + i * 4), _mm_shuffle_epi8(v, mask));
+    }
+    swap_kernel_scalar(dst + i * 4, src + i * 4, count - i);
+}
+
+__attribute__((target("avx2")))
+static void swap_kernel_avx2(unsigned char *dst, const unsigned char *src, size_t count) {
+    // the shuffle works per 128-bit lane, so the pattern repeats
+    const __m256i mask = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                          3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(src + i * 4));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(src + i * 4 + 32));
+        _mm256_storeu_si256((__m256i *)(dst + i * 4), _mm256_shuffle_epi8(a, mask));
+        _mm256_storeu_si256((__m256i *)(dst + i * 4 + 32), _mm256_shuffle_epi8(b, mask));
+    }
+    for (; i + 8 <= count; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(src + i * 4));
+        _mm256_storeu_si256((__m256i *)(dst + i * 4), _mm256_shuffle_epi8(v, mask));
+    }
+    swap_kernel_scalar(dst + i * 4, src + i * 4, count - i);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void swap_kernel_avx512(unsigned char *dst, const unsigned char *src, size_t count) {
+    const __m512i mask = _mm512_broadcast_i32x4(
+        _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12));
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m512i v = _mm512_loadu_si512((const void *)(src + i * 4));
+        _mm512_storeu_si512((void *)(dst + i * 4), _mm512_shuffle_epi8(v, mask));
+    }
+    // tail under a mask instead of a scalar loop
+    if (i < count) {
+        __mmask16 tail = (__mmask16)((1u << (count - i)) - 1);
+        __m512i v = _mm512_maskz_loadu_epi32(tail, (const void *)(src + i * 4));
+        _mm512_mask_storeu_epi32((void *)(dst + i * 4), tail, _mm512_shuffle_epi8(v, mask));
+    }
+}
+#endif
+
+#if SIF_SWAP_NEON
+static void swap_kernel_neon(unsigned char *dst, const unsigned char *src, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        vst1q_u8(dst + i * 4, vrev32q_u8(vld1q_u8(src + i * 4)));
+    }
+    swap_kernel_scalar(dst + i * 4, src + i * 4, count - i);
+}
+#endif
+
+typedef struct {
+    SwapKernel kernel;
+    const char *name;
+} SwapKernelEntry;
+
+static const SwapKernelEntry *swap_choice;
+
+static void pick_swap_kernel(void) {
+    static const SwapKernelEntry kernels[] = {
+        { swap_kernel_scalar, "scalar" },
+#if SIF_SWAP_X86
+        { swap_kernel_ssse3, "ssse3" },
+        { swap_kernel_avx2, "avx2" },
+        { swap_kernel_avx512, "avx512bw" },
+#endif
+#if SIF_SWAP_NEON
+        { swap_kernel_neon, "neon" },
+#endif
+    };
+    size_t pick = 0;
+
+#if SIF_SWAP_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512bw")) pick = 3;
+    else if (__builtin_cpu_supports("avx2")) pick = 2;
+    else if (__builtin_cpu_supports("ssse3")) pick = 1;
+#elif SIF_SWAP_NEON
+    pick = 1;
+#endif
+
+    // SIF_BYTE_SWAP_KERNEL=scalar pins the reference path (benchmarks, bug reports)
+    const char *force = getenv("SIF_BYTE_SWAP_KERNEL");
+    if (force) {
+        for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+            if (strcmp(force, kernels[k].name) == 0 && k <= pick) pick = k;
+        }
+    }
+    swap_choice = &kernels[pick];
+}
+
+static pthread_once_t swap_once = PTHREAD_ONCE_INIT;
+
+// swap count 32-bit values from src into dst (in place when they are equal)
+void swap_float_array_endian_copy(float *dst, const void *src, size_t count) {
+    pthread_once(&swap_once, pick_swap_kernel);
+    swap_choice->kernel((unsigned char *)dst, (const unsigned char *)src, count);
+}
+
+void swap_float_array_endian(float *data, size_t count) {
+    swap_float_array_endian_copy(data, data, count);
+}
+
+// name of the byte swap kernel in use
+const char *sif_byte_swap_kernel(void) {
+    pthread_once(&swap_once, pick_swap_kernel);
+    return swap_choice->name;
+}
+
+// positional read that retries short reads; returns bytes read or -1
+ssize_t pread_full(int fd, void *buffer, size_t count, int64_t offset) {
+    size_t total = 0;
+    while (total < count) {
+        ssize_t got = pread(fd, (unsigned char *)buffer + total, count - total, (off_t)(offset + total));
+        if (got < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (got == 0) break; // EOF
+        total += (size_t)got;
+    }
+    return (ssize_t)total;
+}
+
 void print_sif_first_line(const char *filename, SifInfo *info) {
-    if (current_verbose_level < SIF_DEBUG) {
+    if (!SIF_LOG_ENABLED(SIF_DEBUG)) {
         return;  
     }
 
@@ -247,6 +409,7 @@ void print_sif_info_summary(const SifInfo *info) {
     PRINT_NORMAL("Cycle Time: %f s\n", info->cycle_time);
     PRINT_NORMAL("Data Offset: 0x%08lX\n", info->data_offset);
     
+    sif_ensure_calibration(info);
     if (info->calibration_coeff_count > 0) {
         PRINT_NORMAL("Calibration Coefficients: ");
         for (int i = 0; i < info->calibration_coeff_count; i++) {
@@ -275,14 +438,17 @@ void print_sif_file_structure(const SifFile *sif_file) {
     PRINT_NORMAL("===================\n");
     PRINT_NORMAL("Total Frames: %d\n", sif_file->info.number_of_frames);
     PRINT_NORMAL("Image Size: %d x %d\n", sif_file->info.image_width, sif_file->info.image_height);
-    PRINT_NORMAL("Tile Count: %d\n", sif_file->tile_count);
+    PRINT_NORMAL("Pixels per Frame: %zu\n", sif_file->info.pixels_per_frame);
     PRINT_NORMAL("\n");
     
-    PRINT_VERBOSE("Tile Information:\n");
-    for (int i = 0; i < sif_file->tile_count; i++) {
-        PRINT_VERBOSE("  Tile %d: offset=0x%08lX, size=%dx%d\n", 
-                     i, sif_file->tiles[i].offset, 
-                     sif_file->tiles[i].width, sif_file->tiles[i].height);
+    // frame offsets are computed, show the first and last few
+    PRINT_VERBOSE("Frame Offsets:\n");
+    for (int i = 0; i < sif_file->frame_count; i++) {
+        if (i == 3 && sif_file->frame_count > 6) {
+            PRINT_VERBOSE("  ...\n");
+            i = sif_file->frame_count - 3;
+        }
+        PRINT_VERBOSE("  Frame %d: offset=0x%08" PRIX64 "\n", i, (uint64_t)sif_frame_offset(sif_file, i));
     }
     
     PRINT_VERBOSE("\nSubimage Information:\n");
@@ -320,7 +486,7 @@ void debug_print_some_lines(FILE* fp, long debug_pos, int num_lines) {
 // Prints a hexadecimal dump (supports starting before a specified position)
 void print_hex_dump(FILE *fp, int target_offset, int before_bytes, int after_bytes) {
 
-    if (current_verbose_level < SIF_DEBUG) {
+    if (!SIF_LOG_ENABLED(SIF_DEBUG)) {
         return;  
     }
 
@@ -416,11 +582,14 @@ double* retrieve_calibration(SifInfo *info, int* calibration_size) {
         *calibration_size = 0;
         return NULL;
     }
+    sif_ensure_calibration(info);
     
-    int width = info->detector_width;
-    if (info->image_length > 0) {
-        width = info->image_length;
+    int64_t length = info->image_length > 0 ? info->image_length : info->detector_width;
+    if (length <= 0 || length > INT_MAX) {
+        *calibration_size = 0;
+        return NULL;
     }
+    int width = (int)length;
     
     PRINT_VERBOSE("→ Retrieving calibration data (width: %d)\n", width);
     
@@ -428,8 +597,15 @@ double* retrieve_calibration(SifInfo *info, int* calibration_size) {
     if (info->has_frame_calibrations && info->number_of_frames > 0) {
         PRINT_VERBOSE("  Found frame-specific calibrations for %d frames\n", info->number_of_frames);
         
-        // 分配 2D 陣列：number_of_frames × width
-        double* calibration = malloc(info->number_of_frames * width * sizeof(double));
+        // 分配 2D 陣列：number_of_frames × width，總數需能以 int 回報
+        size_t total = (size_t)info->number_of_frames * (size_t)width;
+        if (total > (size_t)INT_MAX || total > SIZE_MAX / sizeof(double)) {
+            PRINT_VERBOSE("  ⚠️ %d frames x %d pixels is too large, use extract_calibration\n",
+                          info->number_of_frames, width);
+            *calibration_size = 0;
+            return NULL;
+        }
+        double* calibration = sif_mem_alloc(NULL, total * sizeof(double));
         if (!calibration) {
             *calibration_size = 0;
             return NULL;
@@ -445,24 +621,24 @@ double* retrieve_calibration(SifInfo *info, int* calibration_size) {
                                
                 PRINT_VERBOSE("    Frame %d: %d coefficients -> ", frame + 1, frame_calib->coeff_count);
                 for (int i = 0; i < frame_calib->coeff_count; i++) {
-                    printf("%f ", coefficients[i]);
+                    PRINT_VERBOSE("%f ", coefficients[i]);
                 }
                 PRINT_VERBOSE("\n");
                 
                 // 計算多項式值（對應 Julia 的 p.(1:width)）
                 for (int x = 0; x < width; x++) {
                     double pixel_value = evaluate_polynomial(coefficients, frame_calib->coeff_count, x + 1);
-                    calibration[frame * width + x] = pixel_value;
+                    calibration[(size_t)frame * width + x] = pixel_value;
                 }
             } else {
                 // 如果沒有校準數據，填充 0
                 for (int x = 0; x < width; x++) {
-                    calibration[frame * width + x] = 0.0;
+                    calibration[(size_t)frame * width + x] = 0.0;
                 }
             }
         }
         
-        *calibration_size = info->number_of_frames * width;
+        *calibration_size = (int)total;
         return calibration;
     }
     // 情況2: 有單個校準數據
@@ -470,7 +646,7 @@ double* retrieve_calibration(SifInfo *info, int* calibration_size) {
         PRINT_VERBOSE("  Found global calibration data: %d coefficients\n", info->calibration_coeff_count);
         
         // 分配 1D 陣列：width
-        double* calibration = malloc(width * sizeof(double));
+        double* calibration = sif_mem_alloc(NULL, (size_t)width * sizeof(double));
         if (!calibration) {
             *calibration_size = 0;
             return NULL;
@@ -501,3 +677,78 @@ double* retrieve_calibration(SifInfo *info, int* calibration_size) {
         return NULL;
     }
 }
+
+// string interning: metadata strings such as detector type or axis names
+// repeat across files, so every handle shares one reference-counted copy
+#define SIF_INTERN_BUCKETS 256
+
+typedef struct InternEntry {
+    struct InternEntry *next;
+    uint32_t hash;
+    int refs;
+    char text[];
+} InternEntry;
+
+static InternEntry *intern_table[SIF_INTERN_BUCKETS];
+static pthread_mutex_t intern_lock = PTHREAD_MUTEX_INITIALIZER;
+static const char intern_empty[] = "";
+
+static uint32_t intern_hash(const char *str) {
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (const unsigned char *p = (const unsigned char *)str; *p; p++) {
+        hash = (hash ^ *p) * 16777619u;
+    }
+    return hash;
+}
+
+const char *sif_intern(const char *str) {
+    if (!str || !*str) return intern_empty;
+
+    uint32_t hash = intern_hash(str);
+    InternEntry **bucket = &intern_table[hash % SIF_INTERN_BUCKETS];
+
+    pthread_mutex_lock(&intern_lock);
+
+    for (InternEntry *entry = *bucket; entry; entry = entry->next) {
+        if (entry->hash == hash && strcmp(entry->text, str) == 0) {
+            entry->refs++;
+            pthread_mutex_unlock(&intern_lock);
+            return entry->text;
+        }
+    }
+
+    size_t length = strlen(str);
+    InternEntry *entry = malloc(sizeof(InternEntry) + length + 1);
+    if (!entry) {
+        pthread_mutex_unlock(&intern_lock);
+        return intern_empty;
+    }
+    entry->hash = hash;
+    entry->refs = 1;
+    memcpy(entry->text, str, length + 1);
+    entry->next = *bucket;
+    *bucket = entry;
+
+    pthread_mutex_unlock(&intern_lock);
+    return entry->text;
+}
+
+void sif_intern_release(const char *str) {
+    if (!str || str == intern_empty) return;
+
+    InternEntry *entry = (InternEntry *)(str - offsetof(InternEntry, text));
+
+    pthread_mutex_lock(&intern_lock);
+
+    if (--entry->refs == 0) {
+        InternEntry **link = &intern_table[entry->hash % SIF_INTERN_BUCKETS];
+        while (*link && *link != entry) {
+            link = &(*link)->next;
+        }
+        if (*link) *link = entry->next;
+        free(entry);
+    }
+
+    pthread_mutex_unlock(&intern_lock);
+}
@@ -0,0 +1,275 @@
+/*
+ * csif - Andor SIF Parser in C
+ * Copyright (C) 2025 mithgil
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Multi-threaded checks of the frame cache (CLOCK sweep with pins, the
+// LOADING handoff), the double-buffered frame iterator and the lazily
+// published timestamps, over a small SIF file written at start. Meant to
+// be run under ThreadSanitizer and AddressSanitizer as well
+// (-DSIF_SANITIZER=thread / address).
+
+#define _POSIX_C_SOURCE 200809L  // pthread_barrier_t
+
+#include "sif_parser.h"
+#include "sif_cache.h"
+#include "sif_iter.h"
+#include <inttypes.h>
+#include <pthread.h>
+
+#define TEST_FRAMES 64
+#define TEST_WIDTH 32
+#define TEST_THREADS 8
+#define TEST_ROUNDS 2000
+
+static int failures = 0;
+
+#define CHECK(condition, ...) do {                          \
+    if (!(condition)) {                                     \
+        fprintf(stderr, "FAIL %s:%d: ", __FILE__, __LINE__); \
+        fprintf(stderr, __VA_ARGS__);                       \
+        fprintf(stderr, "\n");                              \
+        __atomic_add_fetch(&failures, 1, __ATOMIC_RELAXED); \
+    }                                                       \
+} while (0)
+
+static float pixel_value(int frame, int pixel) {
+    return (float)(frame * 1000 + pixel + 1);
+}
+
+static int64_t timestamp_value(int frame) {
+    return (int64_t)frame * 250;
+}
+
+// a single-track file in native byte order, laid out as the parser expects
+static FILE *write_test_file(void) {
+    FILE *fp = tmpfile();
+    if (!fp) return NULL;
+
+    const char *user_text = "Test acquisition";
+    fputs("Andor Technology Multi-Channel File\n", fp);
+    fputs("65538 1\n", fp);
+    fputs("65567 1 0 0 1234567 -60.5 ABCDEFGHIJ 0 0.25 0.5 0.75 5 ", fp);
+    fputc('\0', fp);
+    fputs(" 0.1 0.2 0 1 3.0 0 0 0.01 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 500 0 0\n", fp);
+    fputs("DU420_BU\n", fp);
+    fprintf(fp, "%d %d\n", TEST_WIDTH, 1);
+    fputs("45\nC:\\data\\test.sif\n \n", fp);
+    fprintf(fp, "65538 %zu\n%s\n", strlen(user_text), user_text);
+    fputs("65538 ABCDEFGH 1.5 2.5\n", fp);
+    for (int i = 0; i < 8; i++) fputs("x\n", fp);
+    fputs("Shamrock SR-303i\nintensifier\n0 0 0 1 0 0 100 200\n", fp);
+    for (int i = 0; i < 8; i++) fputs("y\n", fp);
+    fputs("65540\nskipline\n100 0.5 0.001 0\nold\nextra\n785.0\n", fp);
+    for (int i = 0; i < 4; i++) fputs("z\n", fp);
+    fputs("Wavelength\nCounts\n", fp);
+    fprintf(fp, "Pixel number65541 1 %d 1 1 %d 1 %d %d\n", TEST_WIDTH, TEST_FRAMES, TEST_WIDTH * TEST_FRAMES,
+            TEST_WIDTH);
+    fprintf(fp, "65538 1 1 %d 1 1 1\n", TEST_WIDTH);
+    fputs("0\n", fp);
+    for (int f = 0; f < TEST_FRAMES; f++) {
+        fprintf(fp, "%" PRId64 "\n", timestamp_value(f));
+    }
+    fputs("0\n", fp);
+
+    for (int f = 0; f < TEST_FRAMES; f++) {
+        float row[TEST_WIDTH];
+        for (int i = 0; i < TEST_WIDTH; i++) row[i] = pixel_value(f, i);
+        fwrite(row, sizeof(float), TEST_WIDTH, fp);
+    }
+
+    fflush(fp);
+    rewind(fp);
+    return fp;
+}
+
+static int frame_matches(const float *data, int frame) {
+    for (int i = 0; i < TEST_WIDTH; i++) {
+        if (data[i] != pixel_value(frame, i)) return 0;
+    }
+    return 1;
+}
+
+typedef struct {
+    SifFile *sif_file;
+    pthread_barrier_t *start;
+    unsigned seed;
+    const int64_t *timestamps;    // sif_get_timestamps result of this thread
+    int unavailable;              // acquires that found every slot pinned
+} Worker;
+
+// every thread first asks for the same frame at once (one reads it, the
+// others wait on LOADING), then pins frames at random so the CLOCK sweep
+// keeps evicting under them
+static void *cache_worker(void *arg) {
+    Worker *worker = arg;
+    SifFile *sif_file = worker->sif_file;
+
+    pthread_barrier_wait(worker->start);
+    const float *shared = sif_cache_acquire(sif_file, TEST_FRAMES / 2);
+    CHECK(shared && frame_matches(shared, TEST_FRAMES / 2), "shared frame");
+    if (shared) sif_cache_release(sif_file, TEST_FRAMES / 2);
+
+    for (int round = 0; round < TEST_ROUNDS; round++) {
+        worker->seed = worker->seed * 1103515245u + 12345u;
+        int frame = (int)((worker->seed >> 16) % TEST_FRAMES);
+
+        const float *data = sif_cache_acquire(sif_file, frame);
+        if (!data) {
+            worker->unavailable++;
+            continue;
+        }
+        CHECK(frame_matches(data, frame), "frame %d changed while pinned", frame);
+        sif_cache_release(sif_file, frame);
+    }
+    return NULL;
+}
+
+static void test_cache(FILE *fp) {
+    SifFile sif_file;
+    CHECK(sif_open(fp, &sif_file) == 0, "open");
+
+    // room for a pin per thread plus two, far fewer frames than the file has
+    size_t frame_bytes = sif_file.info.pixels_per_frame * sizeof(float);
+    CHECK(sif_cache_enable(&sif_file, (TEST_THREADS + 2) * frame_bytes, 0) == 0, "cache enable");
+
+    pthread_barrier_t start;
+    pthread_barrier_init(&start, NULL, TEST_THREADS);
+    pthread_t threads[TEST_THREADS];
+    Worker workers[TEST_THREADS];
+    for (int t = 0; t < TEST_THREADS; t++) {
+        workers[t] = (Worker){ .sif_file = &sif_file, .start = &start, .seed = (unsigned)t * 7919u + 1u };
+        pthread_create(&threads[t], NULL, cache_worker, &workers[t]);
+    }
+
+    int unavailable = 0;
+    for (int t = 0; t < TEST_THREADS; t++) {
+        pthread_join(threads[t], NULL);
+        unavailable += workers[t].unavailable;
+    }
+    pthread_barrier_destroy(&start);
+    CHECK(unavailable == 0, "%d acquires found every slot pinned", unavailable);
+
+    SifCacheStats stats;
+    sif_cache_get_stats(&sif_file, &stats);
+    CHECK(stats.evictions > 0, "no eviction happened");
+    CHECK(stats.frames_cached <= TEST_THREADS + 2, "%d frames cached", stats.frames_cached);
+    CHECK(stats.hits + stats.misses >= (uint64_t)TEST_THREADS * TEST_ROUNDS, "lookups not counted");
+
+    sif_cache_disable(&sif_file);
+    sif_close(&sif_file);
+    rewind(fp);
+}
+
+// a full pass in batches that do not divide the frame count, then passes
+// closed early: after two batches and before the first
+static void test_iterator(FILE *fp) {
+    SifFile sif_file;
+    CHECK(sif_open(fp, &sif_file) == 0, "open");
+
+    SifFrameIter *iter = sif_frame_iter_open(&sif_file, 5, 0);
+    CHECK(iter != NULL, "iterator open");
+
+    const float *frames;
+    int first_frame, count, expected = 0;
+    while (iter && (count = sif_frame_iter_next(iter, &frames, &first_frame)) > 0) {
+        CHECK(first_frame == expected, "batch starts at %d, expected %d", first_frame, expected);
+        for (int k = 0; k < count; k++) {
+            CHECK(frame_matches(frames + (size_t)k * TEST_WIDTH, first_frame + k), "frame %d", first_frame + k);
+        }
+        expected += count;
+    }
+    CHECK(expected == TEST_FRAMES, "iterated %d frames", expected);
+    CHECK(!iter || sif_frame_iter_next(iter, &frames, &first_frame) == 0, "next after the end");
+    sif_frame_iter_close(iter);
+
+    for (int round = 0; round < 50; round++) {
+        iter = sif_frame_iter_open(&sif_file, 3, 0);
+        CHECK(iter != NULL, "iterator open");
+        for (int batch = 0; iter && batch < round % 3; batch++) {
+            CHECK(sif_frame_iter_next(iter, &frames, &first_frame) == 3, "early batch");
+        }
+        sif_frame_iter_close(iter);
+    }
+
+    sif_close(&sif_file);
+    rewind(fp);
+}
+
+static void *timestamp_worker(void *arg) {
+    Worker *worker = arg;
+    pthread_barrier_wait(worker->start);
+    worker->timestamps = sif_get_timestamps(worker->sif_file);
+    return NULL;
+}
+
+// concurrent first calls decode their own copy, one of them is published
+static void test_lazy_timestamps(FILE *fp) {
+    for (int round = 0; round < 20; round++) {
+        SifFile sif_file;
+        SifOpenOptions options = SIF_DEFAULT_OPEN_OPTIONS;
+        options.lazy_timestamps = 1;
+        CHECK(sif_open_ex(fp, &sif_file, options) == 0, "lazy open");
+        CHECK(sif_file.info.timestamps == NULL, "timestamps decoded at open");
+
+        pthread_barrier_t start;
+        pthread_barrier_init(&start, NULL, TEST_THREADS);
+        pthread_t threads[TEST_THREADS];
+        Worker workers[TEST_THREADS];
+        for (int t = 0; t < TEST_THREADS; t++) {
+            workers[t] = (Worker){ .sif_file = &sif_file, .start = &start };
+            pthread_create(&threads[t], NULL, timestamp_worker, &workers[t]);
+        }
+        for (int t = 0; t < TEST_THREADS; t++) {
+            pthread_join(threads[t], NULL);
+        }
+        pthread_barrier_destroy(&start);
+
+        const int64_t *published = sif_get_timestamps(&sif_file);
+        CHECK(published != NULL, "no timestamps");
+        for (int t = 0; t < TEST_THREADS; t++) {
+            CHECK(workers[t].timestamps == published, "thread %d kept its own copy", t);
+        }
+        for (int f = 0; published && f < TEST_FRAMES; f++) {
+            CHECK(published[f] == timestamp_value(f), "timestamp %d", f);
+        }
+
+        sif_close(&sif_file);
+        rewind(fp);
+    }
+}
+
+int main(void) {
+    sif_set_verbose_level(SIF_SILENT);
+
+    FILE *fp = write_test_file();
+    if (!fp) {
+        fprintf(stderr, "Cannot create the test file\n");
+        return 1;
+    }
+
+    test_cache(fp);
+    test_iterator(fp);
+    test_lazy_timestamps(fp);
+    fclose(fp);
+
+    if (failures > 0) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("concurrency tests passed\n");
+    return 0;
+}